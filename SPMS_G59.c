@@ -5,12 +5,29 @@
 #include <sys/wait.h>
 #include <stdbool.h>
 #include <time.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 #define MAX_BOOKINGS 100
-#define MAX_RESOURCES 6
-#define PARKING_SLOTS 10
-#define TIME_SLOTS 24
-#define RESOURCE_STOCK 3 // 3 of each resource/essential category is available.
+#define MAX_OCCURRENCES 200 // recurring occurrences one pass (or the live calendars) may hold at once, on top of the one-off bookings
+#define MAX_PASS_BOOKINGS (MAX_BOOKINGS + MAX_OCCURRENCES) // what one scheduling pass can hold
+#define MAX_RESOURCES 8    // most essentials the table can hold (one stock lane each)
+#define MAX_BAYS 128       // most bays a site can be configured with
+#define MAX_DURATION_MINUTES UINT16_MAX // longest booking, about 1092 hours: BookingRecord holds 16 bits
+#define MAX_TIME_SLOTS 96  // most slots per day (15-minute slots)
+#define MAX_STOCK 8        // most stock of one essential a site can be configured with
+#define MINUTES_PER_DAY 1440
+#define PARKING_SLOTS 10 // default bays of a site
+#define RESOURCE_STOCK 3 // 3 of each resource/essential category is available by default.
+#define FAST_BAYS 64     // sites with at most this many bays use the bitset paths
+#define FEASIBLE_WORDS ((MAX_TIME_SLOTS + 63) / 64) // words of a bitmap with a bit per slot
 
 typedef struct {
     char memberName[20];
@@ -18,12 +35,73 @@ typedef struct {
     char time[6];
     float duration;
     char essentials[MAX_RESOURCES][20];
+    int demand[MAX_RESOURCES]; // stock of each essential it takes, bundles included (set at ingest)
     int priority;           
     int parkingSlot;        
     int accepted;           // 1 = accepted, 0 = rejected
-    char reasonForRejection[256]; // why the booking is rejected (if applicable)
+    int reason;             // REASONS code of why it was rejected (or moved), text at report time
+    int site;               // requested site, SITE_ANY to let routeBookings choose
+    int assignedSite;       // site the booking is scheduled at in the current pass
+    int passIndex;          // position in bookings[] when the pass was handed to the sites
+    int suggestPending;     // rejected in this pass; suggestions are worked out only if asked for
 } Booking;
 
+enum REASONS {
+    REASON_NONE = 0,
+    REASON_ESSENTIALS,      // "One or more essentials unavailable."
+    REASON_NO_BAY,          // "No available parking slots."
+    REASON_DISPLACED,       // "Displaced by higher priority booking."
+    REASON_RESCHEDULED,     // moved by the legacy optimizer
+    REASON_NO_SLOT,         // the legacy optimizer found no other time either
+    REASON_MOVED            // accepted, but shifted from its requested start by a cascaded preemption
+};
+
+// What a site child sends back per booking: only the scheduling outcome and the keys of the
+// booking, packed into 32 bytes. The parent still has the rest (names, essentials) and rebuilds
+// the Booking from its passIndex.
+typedef struct {
+    int32_t day;            // dateToDay of the date
+    uint16_t passIndex;
+    uint16_t startMinute;   // may differ from the request once the legacy optimizer moves it
+    uint16_t durationMinutes; // isValidTime keeps durations within MAX_DURATION_MINUTES
+    int16_t slot;           // bay, -1 if none
+    uint8_t member;         // index in members[]
+    uint8_t priority;
+    uint8_t resourceMask;   // essentials taken, bundles included
+    uint8_t status;         // accepted
+    uint8_t reason;
+    uint8_t site;
+    uint8_t reserved[14];
+} BookingRecord;
+
+_Static_assert(sizeof(BookingRecord) == 32, "BookingRecord must stay 32 bytes");
+
+// A car park structure with its own bays and essentials inventory, up to MAX_BAYS bays and
+// MAX_STOCK of each essential.
+#define MAX_SITES 4
+#define SITE_ANY -1
+#define SITE_UNKNOWN -2
+
+typedef struct {
+    char name[20];
+    int bays;
+    int stock[MAX_RESOURCES];
+} Site;
+
+Site sites[MAX_SITES] = {
+    {"main", PARKING_SLOTS, {RESOURCE_STOCK, RESOURCE_STOCK, RESOURCE_STOCK, RESOURCE_STOCK, RESOURCE_STOCK, RESOURCE_STOCK}}
+};
+int siteCount = 1;
+int requestedSite = SITE_ANY; // "@site" of the command being processed
+
+// Set from the config file at startup, see loadConfig.
+int slotMinutes = 60;                         // length of one availability slot
+int timeSlots = MINUTES_PER_DAY / 60;         // slots per day
+int maxBookings = MAX_BOOKINGS;               // bookings held at once
+int horizonDays = 0;                          // how many days ahead bookings may be made, 0 = no limit
+int retentionDays = 0;                        // how many past days bookings are kept, 0 = forever
+int fastPathsEnabled = 1;                     // 0 = always use the generic per-cell scans
+
 typedef struct {
     char date[11];
     int startMinutes;
@@ -31,14 +109,172 @@ typedef struct {
     int resourceCount[MAX_RESOURCES]; // record of how many of each resource is needed
 } OptimizedSlot;
 
-OptimizedSlot optimizedSlots[MAX_BOOKINGS];
+OptimizedSlot optimizedSlots[MAX_PASS_BOOKINGS];
 int optimizedSlotCount = 0;
 
-Booking initialBookings[MAX_BOOKINGS]; // Initial bookings that are read from the report
-Booking bookings[MAX_BOOKINGS];
+// One booking as seen by the optimizer: its hourly cells, bay need and essentials demand.
+typedef struct {
+    int index;              // position in bookings[]
+    int startSlot;
+    int endSlot;
+    int needsBay;
+    int demand[MAX_RESOURCES];
+    int weight;
+} OptiItem;
+
+// Bays and essentials in use per hour for a single date while the optimizer searches.
+typedef struct {
+    int bays[MAX_TIME_SLOTS];
+    int resources[MAX_TIME_SLOTS][MAX_RESOURCES];
+} OptiLoad;
+
+int optiMoveBudget = 20000;     // removal trials the local search may make per pass
+int optiTimeCapMs = 1000;       // safety cap only; the move budget decides the schedule
+int optiPriorityWeighted = 0;   // 1 = maximise priority-weighted acceptance instead of count
+int suggestionsEnabled = 1;     // 0 = the site children skip the pending suggestions (benchmarks, reruns)
+
+// How FCFS/PRIORITY free a bay for a higher priority booking.
+enum PREEMPTION_MODES {
+    PREEMPT_LEGACY = 0,   // evict the first overlapping lower priority booking and drop it
+    PREEMPT_CASCADE = 1   // evict the cheapest victim set and try to re-place every victim
+};
+
+#define PREEMPT_MAX_DEPTH 2 // how many times a re-placed victim may displace others in turn
+#define PREEMPT_MAX_SHIFT 2 // hours a displaced booking may be moved to stay accepted
+
+// How a free bay is picked when several are free over the booking.
+enum BAY_POLICIES {
+    BAY_FIRST_FIT = 0,  // lowest-index free bay
+    BAY_BEST_FIT = 1,   // bay whose free gap around the booking is smallest
+    BAY_LOOKAHEAD = 2,  // avoid leaving gaps too short for any booking still to be scheduled
+    BAY_POLICY_COUNT = 3
+};
+
+int bayPolicy = BAY_FIRST_FIT;
+int passOrder[MAX_PASS_BOOKINGS]; // bookings[] indexes in the order the pass schedules them
+int schedulingIndex = -1;    // position in passOrder of the booking being scheduled; later ones are still pending
+
+int preemptionMode = PREEMPT_CASCADE;
+int evictionCount = 0;  // bookings evicted during the last pass
+int replacedCount = 0;  // evicted bookings that were admitted again
+int droppedCount = 0;   // evicted bookings that ended up rejected
+
+Booking initialBookings[MAX_PASS_BOOKINGS]; // Initial bookings that are read from the report
+Booking bookings[MAX_PASS_BOOKINGS];
 int totalBookings = 0;
-int parkingAvailability[TIME_SLOTS][PARKING_SLOTS] = {0}; // 0 means available
-int resourceAvailability[TIME_SLOTS][MAX_RESOURCES] = {0}; 
+
+// Live state of a one-off booking (same index as initialBookings), kept between reports so
+// bookings can be cancelled or moved by the handle they were given at submission.
+enum LIVE_STATUS {
+    LIVE_WAITING = 0,   // did not fit when submitted (or lost its place)
+    LIVE_ADMITTED = 1,  // holds a bay and essentials in a live calendar
+    LIVE_CANCELLED = 2  // removed from the tables at the next compaction
+};
+
+typedef struct {
+    int handle;
+    int site;    // site whose live calendar holds the booking
+    int bay;     // bay held there, -1 if none
+    int status;
+} LiveEntry;
+
+LiveEntry liveEntries[MAX_BOOKINGS];
+int nextHandle = 1;
+
+// Waiting bookings, kept sorted by (day, start slot, slots, mask) so that capacity freed on one
+// day and time range only has to look at the waiting bookings that overlap it.
+#define WAIT_NEEDS_BAY (1 << MAX_RESOURCES) // mask bit of bookings that need a bay
+
+typedef struct {
+    int day;        // dateToDay of the booking date
+    int startSlot;
+    int slots;
+    int mask;       // essentials the booking takes, plus WAIT_NEEDS_BAY
+    int handle;
+} WaitKey;
+
+WaitKey waitlist[MAX_BOOKINGS + MAX_OCCURRENCES]; // one-off bookings and live recurring occurrences
+int waitCount = 0;
+int waitLongest = 0;     // most slots of any waiting booking, bounds the overlap scan
+int waitlistedCount = 0; // bookings that had to wait when submitted
+int promotedCount = 0;   // of those, bookings admitted later from the waitlist
+
+// Availability of one booked date. Bookings on different dates never compete for bays or stock.
+typedef struct {
+    char date[11];
+    unsigned char parking[MAX_TIME_SLOTS][MAX_BAYS]; // 0 means occupied
+    int resources[MAX_TIME_SLOTS][MAX_RESOURCES];    // remaining stock
+    uint64_t busyBays[MAX_TIME_SLOTS];   // bit j set while bay j (< FAST_BAYS) is occupied
+    uint64_t stockLanes[MAX_TIME_SLOTS]; // remaining stock packed one byte per resource
+    int version;                         // bumped on every change, invalidates cached suggestions
+} DayCalendar;
+
+// Free-window index of one day: how many consecutive hours are free from each hour onwards,
+// for the best bay and for each resource at each stock level.
+typedef struct {
+    int builtVersion;
+    int bayRun[MAX_TIME_SLOTS + 1];
+    int resourceRun[MAX_RESOURCES][MAX_STOCK + 1][MAX_TIME_SLOTS + 1];
+} FreeWindowIndex;
+
+// Feasible start hours for one (day, duration, demand) query, valid while the day is unchanged.
+typedef struct {
+    int day;
+    int version;
+    int durationSlots;
+    int demandKey;
+    int count;
+    int starts[MAX_TIME_SLOTS];
+} SuggestionCacheEntry;
+
+#define SUGGESTION_CACHE_SIZE 64
+#define SUGGESTION_COUNT 3
+#define MAX_DAYS (MAX_PASS_BOOKINGS + 1) // one page per booking plus the blank page of resetAvailability
+
+// A set of day pages with their indexes. Pages never move; dayOrder keeps them sorted by date.
+typedef struct {
+    int site;   // pages are created with the capacity of this site
+    DayCalendar days[MAX_DAYS];
+    FreeWindowIndex freeWindows[MAX_DAYS];
+    int dayOrder[MAX_DAYS];
+    int dayCount;
+    SuggestionCacheEntry suggestionCache[SUGGESTION_CACHE_SIZE];
+} Calendar;
+
+Calendar passCalendar;  // scratch state of a scheduling pass
+Calendar liveCalendars[MAX_SITES]; // bookings admitted as they are submitted, see admitLive
+Calendar *calendar = &passCalendar;
+int currentDay = 0;
+// The schedulers work on the page of the booking being processed (see selectDay).
+unsigned char (*parkingAvailability)[MAX_BAYS] = passCalendar.days[0].parking;
+int (*resourceAvailability)[MAX_RESOURCES] = passCalendar.days[0].resources;
+
+// Undo log of the calendar writes made inside a transaction (see beginTransaction). A stock entry
+// records one adjustStock call, a bay entry one cell setBayRange actually changed, so rolling back
+// costs what the tentative placement touched.
+enum UNDO_KINDS {
+    UNDO_STOCK,
+    UNDO_BAY
+};
+
+typedef struct {
+    DayCalendar *page;
+    uint64_t demand;          // UNDO_STOCK: packed demand that was added sign times
+    short startSlot, endSlot; // UNDO_STOCK: range; UNDO_BAY: startSlot is the cell's slot
+    short bay;
+    signed char sign;         // UNDO_STOCK: sign passed to adjustStock
+    unsigned char value;      // UNDO_BAY: the cell before the write
+    unsigned char kind;
+} UndoEntry;
+
+#define UNDO_LOG_SIZE (MAX_PASS_BOOKINGS * MAX_TIME_SLOTS * 2)
+#define MAX_TRANSACTION_DEPTH 8
+
+UndoEntry undoLog[UNDO_LOG_SIZE];
+int undoCount = 0;
+int transactionMarks[MAX_TRANSACTION_DEPTH]; // undoCount when each open transaction began
+int transactionDepth = 0;
+int undoOverflow = 0; // set when a write could not be logged; rollbacks are then refused
 
 // the lower the priority value, the higher the priority.
 enum PRIORITIES {
@@ -48,38 +284,488 @@ enum PRIORITIES {
     PRIORITY_ESSENTIAL = 4
 };
 
-const char *resourceNames[MAX_RESOURCES] = {
-    "battery",
-    "cable",
-    "locker",
-    "umbrella",
-    "inflation",
-    "valetpark"
+// Essentials and the essentials each one needs with it, loaded into resourceNames/bundleMask at
+// startup. A config file can add more with "essential <name> [<needed> ...]".
+const char *defaultEssentials[] = {
+    "battery cable",
+    "cable battery",
+    "locker umbrella",
+    "umbrella locker",
+    "inflation valetpark",
+    "valetpark inflation"
+};
+
+char resourceNames[MAX_RESOURCES][20];
+char essentialNeeds[MAX_RESOURCES][100]; // needed essentials as written, resolved by closeBundles
+int bundleMask[MAX_RESOURCES];           // bit n set if one request of the essential takes essential n
+int essentialCount = 0;
+
+// A booking that repeats, stored once and expanded only for the days a pass touches.
+enum RECURRENCES {
+    RECUR_DAILY = 0,
+    RECUR_WEEKDAYS = 1,  // Monday to Friday
+    RECUR_WEEKLY = 2
 };
 
+#define MAX_RULES 100
+#define MAX_RULE_COUNT 36500 // most occurrences a counted rule may ask for, 100 years of daily ones
+
+typedef struct {
+    char memberName[20];
+    int firstDay;       // day number (see dateToDay) of the first occurrence
+    int lastDay;        // no occurrence after this day
+    int count;          // maximum number of occurrences, 0 = until lastDay
+    int frequency;
+    char time[6];
+    float duration;
+    char essentials[MAX_RESOURCES][20];
+    int demand[MAX_RESOURCES];
+    int priority;
+    int site;
+} RecurrenceRule;
+
+RecurrenceRule recurrenceRules[MAX_RULES];
+int totalRules = 0;
+
+// An occurrence of a recurring rule held in the live calendars. Occurrences are worked out only
+// for the days a query or a live admission reads (see expandLiveDays), so the table holds the
+// active window, not every occurrence of every rule. Their handles are negative.
+typedef struct {
+    int rule;          // index in recurrenceRules
+    int day;
+    Booking booking;
+    LiveEntry entry;
+} LiveOccurrence;
+
+#define OCCURRENCE_ROW MAX_BOOKINGS // live rows from here on are liveOccurrences (see liveBooking)
+
+LiveOccurrence liveOccurrences[MAX_OCCURRENCES]; // sorted by (day, rule)
+int liveOccurrenceCount = 0;
+int nextOccurrenceHandle = -1;
+int liveCutoffDay = 0; // days before the last expiry cutoff are not expanded again
+int passBaseBookings = 0; // one-off bookings; the rest of bookings[] are expanded occurrences
+
 const char *members[5] = {"member_A", "member_B", "member_C", "member_D", "member_E"};
 
+// Usage of one scheduled pass, gathered while the schedule comes back from the sites so the
+// summary report does not have to run the algorithms again. Minutes are exact (not whole slots)
+// and cut at midnight; essentials count with their bundles.
+#define USAGE_HOURS 24
+
+typedef struct {
+    int recorded;                           // set by runScheduler, cleared by endPass
+    int accepted;
+    int moved;                              // accepted at another time than requested (REASON_MOVED)
+    float fragmentation;
+    int firstDay, lastDay;                  // date range of the pass
+    int dateCount;
+    int dates[MAX_DAYS];                    // dateToDay of each booked date, ascending
+    float bayMinutes[MAX_SITES];
+    float resourceMinutes[MAX_RESOURCES];
+    float bayHeat[MAX_DAYS][USAGE_HOURS];   // occupied bay-minutes per booked date and hour of day
+    float essentialHeat[MAX_DAYS][USAGE_HOURS];
+} PassUsage;
+
+PassUsage passUsage[3]; // FCFS, PRIORITY, OPTIMIZED
+
+// Hot-path counters. Each process counts into its own copy; the site children send theirs back
+// with the schedule and the parent adds them up (mergeStats). Build with -DSPMS_COUNTERS=0 to
+// compile every counter and phase timer out.
+#ifndef SPMS_COUNTERS
+#define SPMS_COUNTERS 1
+#endif
+
+enum PHASES {
+    PHASE_INGEST = 0,   // addBooking, live admission included
+    PHASE_ROUTE,        // routeBookings
+    PHASE_SCHEDULE,     // scheduleSites, as the parent sees it
+    PHASE_REPORT,       // printBookings
+    PHASE_SUMMARY,      // generateSummaryReport, its own scheduling included
+    PHASE_COUNT
+};
+
+typedef struct {
+    long allocateCalls, allocateFailures, releaseCalls;
+    long baySearches, bayProbes;    // probes: bay cells, or bitset words, examined
+    long displacements;
+    long suggestionCalls, suggestionProbes, suggestionCacheHits;
+    long preemptionSearches, preemptionProbes; // new start times looked up for displaced bookings
+    long scheduled[4], accepted[4]; // FCFS, PRIORITY, OPTIMIZED, other schedulers
+    double phaseMs[PHASE_COUNT];
+} Stats;
+
+#if SPMS_COUNTERS
+Stats stats;
+#define COUNT(field) (stats.field++)
+#define COUNT_ADD(field, n) (stats.field += (n))
+#define PHASE_BEGIN(phase) double phase##_start = nowMs()
+#define PHASE_END(phase) (stats.phaseMs[phase] += nowMs() - phase##_start)
+#else
+#define COUNT(field) ((void)0)
+#define COUNT_ADD(field, n) ((void)0)
+#define PHASE_BEGIN(phase) ((void)0)
+#define PHASE_END(phase) ((void)0)
+#endif
+pid_t mainPid; // the atexit dump only runs in the main process, not in forked children
+
+// Timeline of one site child, stamped with the monotonic clock (shared by parent and children)
+// and sent ahead of the schedule, so --trace can split a pass into process overhead and work.
+typedef struct {
+    double started;       // first thing the child does after fork
+    double computeStart;  // bookings filtered and calendar reset, scheduler starts
+    double computeEnd;
+    double suggestEnd;    // pending suggestions printed (see printPendingSuggestions)
+    double writeStart;    // child starts writing the schedule to the pipe
+} SiteTrace;
+
+int traceEnabled = 0;          // ./SPMS --trace prints the timeline of every pass to stderr
+double lastScheduleMs = 0;     // wall time of the last scheduleSites, parent side
+double lastComputeMs = 0;      // longest child compute in it (sites run in parallel)
+
+// What-if capacity simulation. Each axis varies the bays, the stock of every essential, or the
+// stock of one essential of every site; values are absolute ("20") or relative ("+2", "-1").
+// The grid is every combination of the axis values.
+#define SIM_MAX_AXES 4
+#define SIM_MAX_VALUES 8
+#define SIM_MAX_SCENARIOS 64
+#define SIM_BAYS -2  // (-1 is an unknown essential)
+#define SIM_STOCK -3
+
+typedef struct {
+    int target;                 // SIM_BAYS, SIM_STOCK or an essential index
+    int count;
+    int values[SIM_MAX_VALUES];
+    int relative[SIM_MAX_VALUES];
+} SimAxis;
+
+typedef struct {
+    float accepted[3];      // share of bookings accepted by FCFS, PRIORITY, OPTIMIZED
+    float bayUse[3];        // bay-hours used / available
+    float essentialUse[3];  // essential-hours used / available
+} SimResult;
+
+// Free capacity of one site over a range of dates and a time window on each of them, as the
+// live calendars hold it (bookings admitted at submission). See queryAvailability.
+typedef struct {
+    int bays;                   // bays free for the whole window on every date
+    int fewestBays;             // fewest bays free at any one slot of the window
+    int stock[MAX_RESOURCES];   // stock of each essential free for the whole window
+} Availability;
+
+// Columnar schedule export (exportSchedule): a header, then for every algorithm one contiguous
+// array per column, each starting on an EXPORT_ALIGN boundary so a reader can mmap the file and
+// use the arrays in place. Row i of every array is booking i of the pass, for every algorithm.
+#define EXPORT_MAGIC "SPMSCOL1"
+#define EXPORT_COLUMNS 10
+#define EXPORT_ALIGN 64
+
+const char *exportColumns[EXPORT_COLUMNS] = {
+    "member", "day", "start", "duration", "type", "resources", "slot", "status", "reason", "site"
+};
+const int exportWidths[EXPORT_COLUMNS] = {1, 4, 2, 2, 1, 1, 2, 1, 1, 1}; // day and slot are signed
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t rows;
+    uint32_t algorithmCount;
+    uint32_t columnCount;
+    char algorithms[3][16];
+    char columns[EXPORT_COLUMNS][16];
+    uint8_t widths[EXPORT_COLUMNS];
+    uint8_t reserved[6];
+    uint64_t offsets[3][EXPORT_COLUMNS]; // from the start of the file
+} ExportHeader;
+
 // Prototypes
 void addBooking(char *memberName, char *date, char *time, float duration, char essentials[MAX_RESOURCES][20], int priority, int isEssentialBooking);
+void addBatch(const char *batchFile);
+int dateToDay(const char *date);
+void dayToDate(int dayNumber, char *date);
+int dayOfWeek(int dayNumber);
+int getBookingPriority(const char *type);
+const char* addRecurrence(const char *command);
+int recurrenceOccurrence(RecurrenceRule *rule, int dayNumber);
+int lastOccurrenceDay(RecurrenceRule *rule);
+int expandRecurrencesOn(int dayNumber);
+int beginPass(const char *args);
+void endPass();
+void runScheduler(void (*scheduler)(), const char *algorithm);
+void useCalendar(Calendar *target);
+Booking *liveBooking(int i);
+LiveEntry *liveEntry(int i);
+int admitLive(int i);
+int placeLive(Booking *b, LiveEntry *entry);
+int occurrencePosition(int day, int rule);
+int expandLiveDays(int fromDay, int toDay);
+void dropOccurrences(const int retired[], const int remap[], int cutoffDay);
+void occurrenceBooking(RecurrenceRule *rule, const char *date, Booking *b);
+int releaseLive(int i);
+WaitKey waitKeyOf(int i);
+int compareWaitKeys(const WaitKey *a, const WaitKey *b);
+int waitPosition(const WaitKey *key);
+void enqueueWaiting(int i);
+void dequeueWaiting(int i);
+int compareWaitPriority(const void *a, const void *b);
+void promoteWaiting(const char *date, int startSlot, int endSlot, int freedMask);
+int findBookingByHandle(int handle);
+int findLiveRow(int handle);
+void compactCancelled();
+int expireBefore(int cutoffDay);
+void expireIfDue();
+void cancelBooking(int handle);
+void modifyBooking(int handle, char *date, char *time, float duration);
+int takeSitePreference(char *command);
+const char* addSite(const char *command);
+int siteCanServe(int s, Booking *b, int demand[MAX_RESOURCES]);
+float siteLoad(int s, Booking *b, int demand[MAX_RESOURCES], float bayHours, float resourceHours[MAX_RESOURCES]);
+int rankSites(Booking *b, int demand[MAX_RESOURCES], float load[MAX_SITES], int order[MAX_SITES]);
+void routeBookings();
+int readAll(int fd, void *buffer, size_t size);
+void scheduleSites(void (*scheduler)(), float fragmentation[]);
+int usageIndex(void (*scheduler)());
+const char* schedulerName(void (*scheduler)());
+void mergeStats(const Stats *child);
+void printStats(FILE *out);
+void dumpStatsAtExit();
+void recordUsage(PassUsage *usage, float fragmentation[MAX_SITES]);
+void printHeatmap(PassUsage *usage, const char *algorithm);
+int useBitsets();
+int useStockLanes();
+uint64_t packStock(const int values[MAX_RESOURCES]);
+void refreshDayMasks(DayCalendar *page);
+void adjustStock(int startSlot, int endSlot, int demand[MAX_RESOURCES], int sign);
+UndoEntry* logUndo(DayCalendar *page, int kind);
+void beginTransaction();
+void commitTransaction();
+int rollbackTransaction();
+int stockFits(int startSlot, int endSlot, int demand[MAX_RESOURCES]);
+uint64_t busyBaysOver(int startSlot, int endSlot);
+const char* feasibilityKernelName();
+void andWords(uint64_t *target, const uint64_t *source, int count);
+void feasibleStarts(int day, int durationSlots, int needsBay, const int demand[MAX_RESOURCES], uint64_t bitmap[FEASIBLE_WORDS]);
+void benchmarkFeasibility();
+void benchmarkCapacity();
+int todayDay();
+int loadConfig(const char *path);
+const char* addEssential(const char *spec);
+const char* closeBundles();
+void loadDefaultEssentials();
+float meanFragmentation(float fragmentation[MAX_SITES]);
 void processBookings_FCFS();
 void processBookings_Priority();
+void scheduleBooking(Booking *b);
+int findFreeBay(int startSlot, int endSlot);
+int chooseBay(Booking *b, int startSlot, int endSlot);
+float bayFragmentation();
+const char* getBayPolicyName(int policy);
+int displaceFirstOverlap(Booking *b, int startMinutes, int durationMinutes);
+int disruptionCost(Booking *b);
+int preemptBay(Booking *b, int startMinutes, int durationMinutes, int resourcesAllocated, int depth);
+int replaceVictim(Booking *v, int depth);
+void resetPreemptionStats();
+void comparePreemption();
+const char* applyScenario(SimAxis axes[], int axisCount, int scenario, char *label, size_t labelSize);
+void simulateScenario(SimResult *result);
+void simulate(const char *args);
+uint64_t nextRandom(uint64_t *state);
+double randomUnit(uint64_t *state);
+int randomWeighted(uint64_t *state, const double weights[], int count);
+int parseWeights(char *list, char names[][20], double weights[], int max);
+const char* generateBatch(const char *args);
+int compareDoubles(const void *a, const void *b);
+double percentile(const double sorted[], int count, double p);
+int muteOutput();
+void restoreOutput(int saved);
+void clearBookings();
+void benchmarkSuite(const char *args);
+const char* compareSchedules(const Booking *reference, const Booking *candidate, int count, int *index);
+void fuzzEngines(const char *args);
+int compareLines(const void *a, const void *b);
+int readReportLines(FILE *file, char *lines[], int max);
+int goldenVersion(const char *name, char *id, int size);
+void checkGolden(const char *args);
 void processBookings_Optimized();
+void processBookings_OptimizedLegacy();
 void printBookings(const char *algorithm);
-int allocateResources(int startMinutes, int durationMinutes, char essentials[MAX_RESOURCES][20]);
-void releaseResources(int startMinutes, int durationMinutes, char essentials[MAX_RESOURCES][20]);
+int allocateResources(int startMinutes, int durationMinutes, int demand[MAX_RESOURCES]);
+void releaseResources(int startMinutes, int durationMinutes, int demand[MAX_RESOURCES]);
 int timeToMinutes(char *time);
 int durationToMinutes(float duration);
-int compareBookings(const void *a, const void *b);
+void sortByPriority();
+void setArrivalOrder();
 int getResourceIndex(const char *resourceName);
 int contains(char essentials[MAX_RESOURCES][20], const char *item);
-void suggestAlternativeSlots(float durationHours, char *memberName, char *date, char *time);
+void suggestAlternativeSlots(Booking *b);
+void printPendingSuggestions();
+void suggestForHandle(int handle);
+int findNearestStarts(int day, int durationSlots, int needsBay, int demand[MAX_RESOURCES], int requestedSlot, int k, int result[], int forSuggestion);
+void buildFreeWindowIndex(int day);
+int selectDay(const char *date);
+int dayOrderPosition(const char *date);
+const char* queryAvailability(int site, const char *fromDate, const char *toDate, int startMinutes, int endMinutes, Availability *result);
+void printAvailability(const char *args);
+int slotEnd(int startMinutes, int durationMinutes);
+void reclaimBlankDay(int *position);
+void removeDay(int o);
+void setBayRange(int startSlot, int endSlot, int bay, int value);
 char* calculateEndTime(const char* startTime, float duration);
 const char* getBookingType(int priority);
+const char* getReasonText(int reason);
+BookingRecord packBooking(const Booking *b);
+void unpackBooking(const BookingRecord *record, Booking *b);
+long currentRssKb();
+void benchmarkRecords(const char *args);
+void gatherColumn(const BookingRecord *records, int rows, int column, unsigned char *out);
+const char* writeExport(const char *path, const char *algorithms[], BookingRecord *records[], int algorithmCount, int rows);
+void exportSchedule(const char *args);
+void inspectExport(const char *path);
+void benchmarkExport(const char *args);
 void generateSummaryReport();
 int isValidDate(char *date);
 int isValidTime(char *time, float duration);
 int isValidMember(char *memberName);
 int isValidResource(char *resource);
+void computeResourceDemand(char essentials[MAX_RESOURCES][20], int demand[MAX_RESOURCES]);
+void resetAvailability();
+double nowMs();
+int bookingWeight(int priority);
+int compareOptiItems(const void *a, const void *b);
+int optiFits(OptiLoad *load, OptiItem *item);
+int optiFootprint(OptiItem *item);
+void optiApply(OptiLoad *load, OptiItem *item, int sign);
+void optimizeDate(OptiItem *items, int n, int selected[], int *movesLeft, double deadline);
+void benchmarkOptimizer();
+
+// Runs every request line of a batch file as if it had been typed, reporting bad lines by number.
+void addBatch(const char *batchFile) {
+    char memberName[20], date[11], time[6], essentials[MAX_RESOURCES][20];
+    float duration;
+    FILE *file = fopen(batchFile, "r");
+    if (file == NULL) {
+        printf("Cannot open batch file: %s\n", batchFile);
+        printf("-> [Pending]\n");
+        return;
+    }
+    char line[128];
+    int lineNum = 0;
+    while (fgets(line, sizeof(line), file)) {
+        lineNum++;
+        line[strcspn(line, "\n")] = 0;
+        for (int i = 0; i < MAX_RESOURCES; i++) {
+            strcpy(essentials[i], "");
+        }
+        requestedSite = takeSitePreference(line);
+        if (requestedSite == SITE_UNKNOWN) {
+            printf("Error in batch file %s at line %d: Unknown site\n", batchFile, lineNum);
+            continue;
+        }
+        if (strncmp(line, "addParking", 10) == 0) {
+            sscanf(line, "addParking -%s %s %s %f %s %s %s %s %s %s %s",
+                   memberName, date, time, &duration, essentials[0], essentials[1], essentials[2],
+                   essentials[3], essentials[4], essentials[5], essentials[6]);
+            if (!isValidMember(memberName)) {
+                printf("Error in batch file %s at line %d: Invalid member name '%s'\n", batchFile, lineNum, memberName);
+                continue;
+            }
+            if (!isValidDate(date)) {
+                printf("Error in batch file %s at line %d: Invalid date '%s' (Expected: YYYY-MM-DD)\n", batchFile, lineNum, date);
+                continue;
+            }
+            if (!isValidTime(time, duration)) {
+                printf("Error in batch file %s at line %d: Invalid time '%s' (Expected: HH:MM) or invalid duration\n", batchFile, lineNum, time);
+                continue;
+            }
+            for (int i = 0; i < MAX_RESOURCES && strlen(essentials[i]) > 0; i++) {
+                if (!isValidResource(essentials[i])) {
+                    printf("Error in batch file %s at line %d: Invalid resource '%s'\n", batchFile, lineNum, essentials[i]);
+                    continue;
+                }
+            }
+            addBooking(memberName, date, time, duration, essentials, PRIORITY_PARKING, 0);
+            printf("-> [Pending] %s\n", line);
+        } else if (strncmp(line, "addReservation", 14) == 0) {
+            sscanf(line, "addReservation -%s %s %s %f %s %s %s %s %s %s %s",
+                   memberName, date, time, &duration, essentials[0], essentials[1], essentials[2],
+                   essentials[3], essentials[4], essentials[5], essentials[6]);
+            if (!isValidMember(memberName)) {
+                printf("Error in batch file %s at line %d: Invalid member name '%s'\n", batchFile, lineNum, memberName);
+                continue;
+            }
+            if (!isValidDate(date)) {
+                printf("Error in batch file %s at line %d: Invalid date '%s' (Expected: YYYY-MM-DD)\n", batchFile, lineNum, date);
+                continue;
+            }
+            if (!isValidTime(time, duration)) {
+                printf("Error in batch file %s at line %d: Invalid time '%s' (Expected: HH:MM) or invalid duration\n", batchFile, lineNum, time);
+                continue;
+            }
+            for (int i = 0; i < MAX_RESOURCES && strlen(essentials[i]) > 0; i++) {
+                if (!isValidResource(essentials[i])) {
+                    printf("Error in batch file %s at line %d: Invalid resource '%s'\n", batchFile, lineNum, essentials[i]);
+                    continue;
+                }
+            }
+            addBooking(memberName, date, time, duration, essentials, PRIORITY_RESERVATION, 0);
+            printf("-> [Pending] %s\n", line);
+        } else if (strncmp(line, "addEvent", 8) == 0) {
+            sscanf(line, "addEvent -%s %s %s %f %s %s %s %s %s %s %s",
+                   memberName, date, time, &duration, essentials[0], essentials[1], essentials[2],
+                   essentials[3], essentials[4], essentials[5], essentials[6]);
+            if (!isValidMember(memberName)) {
+                printf("Error in batch file %s at line %d: Invalid member name '%s'\n", batchFile, lineNum, memberName);
+                continue;
+            }
+            if (!isValidDate(date)) {
+                printf("Error in batch file %s at line %d: Invalid date '%s' (Expected: YYYY-MM-DD)\n", batchFile, lineNum, date);
+                continue;
+            }
+            if (!isValidTime(time, duration)) {
+                printf("Error in batch file %s at line %d: Invalid time '%s' (Expected: HH:MM) or invalid duration\n", batchFile, lineNum, time);
+                continue;
+            }
+            for (int i = 0; i < MAX_RESOURCES && strlen(essentials[i]) > 0; i++) {
+                if (!isValidResource(essentials[i])) {
+                    printf("Error in batch file %s at line %d: Invalid resource '%s'\n", batchFile, lineNum, essentials[i]);
+                    continue;
+                }
+            }
+            addBooking(memberName, date, time, duration, essentials, PRIORITY_EVENT, 0);
+            printf("-> [Pending] %s\n", line);
+        } else if (strncmp(line, "bookEssentials", 14) == 0) {
+            sscanf(line, "bookEssentials -%s %s %s %f %s",
+                   memberName, date, time, &duration, essentials[0]);
+            if (!isValidMember(memberName)) {
+                printf("Error in batch file %s at line %d: Invalid member name '%s'\n", batchFile, lineNum, memberName);
+                continue;
+            }
+            if (!isValidDate(date)) {
+                printf("Error in batch file %s at line %d: Invalid date '%s' (Expected: YYYY-MM-DD)\n", batchFile, lineNum, date);
+                continue;
+            }
+            if (!isValidTime(time, duration)) {
+                printf("Error in batch file %s at line %d: Invalid time '%s' (Expected: HH:MM) or invalid duration\n", batchFile, lineNum, time);
+                continue;
+            }
+            if (strlen(essentials[0]) > 0 && !isValidResource(essentials[0])) {
+                printf("Error in batch file %s at line %d: Invalid resource '%s'\n", batchFile, lineNum, essentials[0]);
+                continue;
+            }
+            addBooking(memberName, date, time, duration, essentials, PRIORITY_ESSENTIAL, 0);
+            printf("-> [Pending] %s\n", line);
+        } else if (strncmp(line, "addRecurring", 12) == 0) {
+            const char *error = addRecurrence(line);
+            if (error != NULL) {
+                printf("Error in batch file %s at line %d: %s\n", batchFile, lineNum, error);
+                continue;
+            }
+            printf("-> [Pending] %s\n", line);
+        } else {
+            printf("Error in batch file %s at line %d: Unrecognized command '%s'\n", batchFile, lineNum, line);
+        }
+    }
+    fclose(file);
+}
 
 int isValidDate(char *date) {
     int year, month, day;
@@ -106,6 +792,9 @@ int isValidTime(char *time, float duration) {
     if (hour < 0 || hour > 23 || minute < 0 || minute > 59) {
         return 0;
     }
+    if (duration * 60 > MAX_DURATION_MINUTES) {
+        return 0;
+    }
     return 1;
 }
 
@@ -119,7 +808,7 @@ int isValidMember(char *memberName) {
 }
 
 int isValidResource(char *resource) {
-    for (int i = 0; i < MAX_RESOURCES; i++) {
+    for (int i = 0; i < essentialCount; i++) {
         if (strcmp(resourceNames[i], resource) == 0) {
             return 1;
         }
@@ -127,7 +816,7 @@ int isValidResource(char *resource) {
     return 0;
 }
 
-int main() {
+int main(int argc, char *argv[]) {
     char command[128];
     char memberName[20];
     char date[11]; 
@@ -135,20 +824,31 @@ int main() {
     char essentials[MAX_RESOURCES][20];
     float duration;
 
-    // Set parking and resource availability to its initial state.
-    memset(parkingAvailability, 1, sizeof(parkingAvailability)); // 1 means available
-    memset(essentials, 0, sizeof(essentials)); // Clear the essentials array (make it empty)
-    for (int i = 0; i < TIME_SLOTS; i++) {
-        for (int j = 0; j < MAX_RESOURCES; j++) {
-            resourceAvailability[i][j] = RESOURCE_STOCK;
-        }
+    mainPid = getpid();
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "--trace") == 0) traceEnabled = 1;
+    }
+    if (getenv("SPMS_STATS") != NULL) atexit(dumpStatsAtExit);
+
+    // Set parking and resource availability to its initial state, with the configured capacities.
+    loadDefaultEssentials();
+    const char *configPath = getenv("SPMS_CONFIG");
+    if (!loadConfig(configPath != NULL ? configPath : "SPMS_G59.cfg")) {
+        if (configPath != NULL) printf("Cannot open config file: %s\n", configPath);
+        resetAvailability();
     }
+    memset(essentials, 0, sizeof(essentials)); // Clear the essentials array (make it empty)
 
     printf("~~ WELCOME TO POLYU! ~~\n");
     while (1) {
         printf("Please enter booking: \n");
         fgets(command, sizeof(command), stdin);
         command[strcspn(command, "\n")] = 0;
+        requestedSite = takeSitePreference(command);
+        if (requestedSite == SITE_UNKNOWN) {
+            printf("Unknown site (add it first with addSite)\n");
+            continue;
+        }
 
         if (strncmp(command, "addParking", 10) == 0) {
             sscanf(command, "addParking -%s %s %s %f %s %s %s %s %s %s %s", memberName, date, time, &duration, essentials[0], essentials[1], essentials[2], essentials[3], essentials[4], essentials[5], essentials[6]);
@@ -243,336 +943,193 @@ int main() {
             addBooking(memberName, date, time, duration, essentials, PRIORITY_ESSENTIAL, 1);
             printf("-> [Pending]\n");
         }
-        else if (strncmp(command, "printBookings -fcfs", 21) == 0) {
-            if (totalBookings > 0) {
-                int pipe_fd[2];
-                if (pipe(pipe_fd) == -1) {
-                    perror("Pipe creation failed");
-                    exit(1);
-                }
-                pid_t pid = fork();
-                if (pid < 0) {
-                    perror("Fork failed");
-                    exit(1);
-                }
-                if (pid == 0) {
-                    close(pipe_fd[0]);
-                    processBookings_FCFS();
-                    write(pipe_fd[1], bookings, sizeof(bookings));
-                    close(pipe_fd[1]);
-                    exit(0);
-                } else {
-                    close(pipe_fd[1]);
-                    wait(NULL);
-                    read(pipe_fd[0], bookings, sizeof(bookings));
-                    close(pipe_fd[0]);
-                    printBookings("FCFS");
-                }
-            } else {
-                printf("No booking(s) have been made.\n");
+        else if (strncmp(command, "benchmarkCapacity", 17) == 0) {
+            benchmarkCapacity();
+        }
+        else if (strncmp(command, "benchmarkFeasibility", 20) == 0) {
+            benchmarkFeasibility();
+        }
+        else if (strncmp(command, "benchmarkRecords", 16) == 0) {
+            benchmarkRecords(command + 16);
+        }
+        else if (strncmp(command, "addSite", 7) == 0) {
+            const char *error = addSite(command);
+            if (error != NULL) printf("%s\n", error);
+        }
+        else if (strncmp(command, "cancelBooking", 13) == 0) {
+            int handle;
+            if (sscanf(command, "cancelBooking -%d", &handle) < 1) {
+                printf("Usage: cancelBooking -<handle>\n");
+                continue;
+            }
+            cancelBooking(handle);
+        }
+        else if (strncmp(command, "expireBookings", 14) == 0) {
+            char date[20] = "";
+            sscanf(command, "expireBookings -%19s", date);
+            if (date[0] != '\0' && !isValidDate(date)) {
+                printf("Usage: expireBookings [-YYYY-MM-DD]\n");
+                continue;
+            }
+            int cutoffDay = date[0] != '\0' ? dateToDay(date) : todayDay() - retentionDays;
+            if (expireBefore(cutoffDay) == 0) printf("No booking(s) to expire.\n");
+        }
+        else if (strncmp(command, "exportSchedule", 14) == 0) {
+            exportSchedule(command + 14);
+        }
+        else if (strncmp(command, "inspectExport", 13) == 0) {
+            char file[64] = "";
+            if (sscanf(command, "inspectExport -%63s", file) < 1) printf("Usage: inspectExport -<file>\n");
+            else inspectExport(file);
+        }
+        else if (strncmp(command, "benchmarkExport", 15) == 0) {
+            benchmarkExport(command + 15);
+        }
+        else if (strncmp(command, "queryAvailability", 17) == 0) {
+            printAvailability(command + 17);
+        }
+        else if (strncmp(command, "suggestSlots", 12) == 0) {
+            int handle;
+            if (sscanf(command, "suggestSlots -%d", &handle) < 1) {
+                printf("Usage: suggestSlots -<handle>\n");
+                continue;
+            }
+            suggestForHandle(handle);
+        }
+        else if (strncmp(command, "modifyBooking", 13) == 0) {
+            int handle;
+            if (sscanf(command, "modifyBooking -%d %10s %5s %f", &handle, date, time, &duration) < 4) {
+                printf("Usage: modifyBooking -<handle> YYYY-MM-DD hh:mm n.n\n");
+                continue;
+            }
+            if (!isValidDate(date)) {
+                printf("Invalid date format: %s (Expected: YYYY-MM-DD)\n", date);
+                continue;
+            }
+            if (!isValidTime(time, duration)) {
+                printf("Invalid time format: %s (Expected: HH:MM, 00:00-23:59) or invalid duration\n", time);
+                continue;
+            }
+            modifyBooking(handle, date, time, duration);
+        }
+        else if (strncmp(command, "addRecurring", 12) == 0) {
+            const char *error = addRecurrence(command);
+            if (error != NULL) {
+                printf("%s\n", error);
+                continue;
+            }
+            printf("-> [Pending]\n");
+        }
+        else if (strncmp(command, "printBookings -fcfs", 19) == 0) {
+            if (beginPass(command + 19)) {
+                runScheduler(processBookings_FCFS, "FCFS");
+                endPass();
             }
         }
         else if (strncmp(command, "printBookings -prio", 19) == 0) {
-            if (totalBookings > 0) {
-                int pipe_fd[2];
-                if (pipe(pipe_fd) == -1) {
-                    perror("Pipe creation failed");
-                    exit(1);
-                }
-                pid_t pid = fork();
-                if (pid < 0) {
-                    perror("Fork failed");
-                    exit(1);
-                }
-                if (pid == 0) {
-                    close(pipe_fd[0]);
-                    processBookings_Priority();
-                    write(pipe_fd[1], bookings, sizeof(bookings));
-                    close(pipe_fd[1]);
-                    exit(0);
-                } else {
-                    close(pipe_fd[1]);
-                    wait(NULL);
-                    read(pipe_fd[0], bookings, sizeof(bookings));
-                    close(pipe_fd[0]);
-                    printBookings("PRIORITY");
-                }
-            } else {
-                printf("No booking(s) have been made.\n");
+            if (beginPass(command + 19)) {
+                runScheduler(processBookings_Priority, "PRIORITY");
+                endPass();
             }
         }
         else if (strncmp(command, "printBookings -opti", 19) == 0) {
-            if (totalBookings > 0) {
-                int pipe_fd[2];
-                if (pipe(pipe_fd) == -1) {
-                    perror("Pipe creation failed");
-                    exit(1);
-                }
-                pid_t pid = fork();
-                if (pid < 0) {
-                    perror("Fork failed");
-                    exit(1);
-                }
-                if (pid == 0) {
-                    close(pipe_fd[0]);
-                    processBookings_Optimized();
-                    write(pipe_fd[1], bookings, sizeof(bookings));
-                    close(pipe_fd[1]);
-                    exit(0);
-                } else {
-                    close(pipe_fd[1]);
-                    wait(NULL);
-                    read(pipe_fd[0], bookings, sizeof(bookings));
-                    close(pipe_fd[0]);
-                    printBookings("OPTIMIZED");
-                }
-            } else {
-                printf("No booking(s) have been made.\n");
+            if (beginPass(command + 19)) {
+                runScheduler(processBookings_Optimized, "OPTIMIZED");
+                endPass();
             }
         }  
         else if (strncmp(command, "printBookings -ALL", 18) == 0) {
-            if (totalBookings > 0) {
-                int pipe_fd[2];
-                if (pipe(pipe_fd) == -1) {
-                    perror("Pipe creation failed");
-                    exit(1);
-                }
-                pid_t pid = fork();
-                if (pid < 0) {
-                    perror("Fork failed");
-                    exit(1);
-                }
-                if (pid == 0) {
-                    close(pipe_fd[0]);
-                    processBookings_FCFS();
-                    write(pipe_fd[1], bookings, sizeof(bookings));
-                    close(pipe_fd[1]);
-                    exit(0);
-                } else {
-                    close(pipe_fd[1]);
-                    wait(NULL);
-                    read(pipe_fd[0], bookings, sizeof(bookings));
-                    close(pipe_fd[0]);
-                    printBookings("FCFS");
-                }
-
-                if (pipe(pipe_fd) == -1) {
-                    perror("Pipe creation failed");
-                    exit(1);
-                }
-                pid = fork();
-                if (pid < 0) {
-                    perror("Fork failed");
-                    exit(1);
-                }
-                if (pid == 0) {
-                    close(pipe_fd[0]);
-                    processBookings_Priority();
-                    write(pipe_fd[1], bookings, sizeof(bookings));
-                    close(pipe_fd[1]);
-                    exit(0);
-                } else {
-                    close(pipe_fd[1]);
-                    wait(NULL);
-                    read(pipe_fd[0], bookings, sizeof(bookings));
-                    close(pipe_fd[0]);
-                    printBookings("PRIORITY");
-                }
-
-                if (pipe(pipe_fd) == -1) {
-                    perror("Pipe creation failed");
-                    exit(1);
-                }
-                pid = fork();
-                if (pid < 0) {
-                    perror("Fork failed");
-                    exit(1);
-                }
-                if (pid == 0) {
-                    close(pipe_fd[0]);
-                    processBookings_Optimized();
-                    write(pipe_fd[1], bookings, sizeof(bookings));
-                    close(pipe_fd[1]);
-                    exit(0);
-                } else {
-                    close(pipe_fd[1]);
-                    wait(NULL);
-                    read(pipe_fd[0], bookings, sizeof(bookings));
-                    close(pipe_fd[0]);
-                    printBookings("OPTIMIZED");
-                    generateSummaryReport();
-                }
-            } else {
-                printf("No booking(s) have been made.\n");
+            if (beginPass(command + 18)) {
+                runScheduler(processBookings_FCFS, "FCFS");
+                runScheduler(processBookings_Priority, "PRIORITY");
+                runScheduler(processBookings_Optimized, "OPTIMIZED");
+                generateSummaryReport();
+                endPass();
             }
         } 
         else if (strncmp(command, "printBookings", 13) == 0) {
+            if (beginPass(command + 13)) {
+                runScheduler(processBookings_FCFS, "FCFS");
+                runScheduler(processBookings_Priority, "PRIORITY");
+                endPass();
+            }
+        } 
+        else if (strncmp(command, "addBatch", 8) == 0) {
+            char batchFile[64];
+            sscanf(command, "addBatch -%63s", batchFile);
+            addBatch(batchFile);
+        }
+        else if (strncmp(command, "setOptimizer", 12) == 0) {
+            int budget;
+            char mode[20] = "";
+            if (sscanf(command, "setOptimizer -%d %19s", &budget, mode) < 1 || budget <= 0) {
+                printf("Usage: setOptimizer -<moves> [weighted]\n");
+                continue;
+            }
+            optiMoveBudget = budget;
+            optiPriorityWeighted = strcmp(mode, "weighted") == 0;
+            printf("Optimizer move budget set to %d (%s).\n", optiMoveBudget,
+                   optiPriorityWeighted ? "priority-weighted" : "maximise bookings");
+        }
+        else if (strncmp(command, "benchmarkOptimizer", 18) == 0) {
             if (totalBookings > 0) {
-                int pipe_fd[2];
-                if (pipe(pipe_fd) == -1) {
-                    perror("Pipe creation failed");
-                    exit(1);
-                }
-                pid_t pid = fork();
-                if (pid < 0) {
-                    perror("Fork failed");
-                    exit(1);
-                }
-                if (pid == 0) {
-                    close(pipe_fd[0]);
-                    processBookings_FCFS();
-                    write(pipe_fd[1], bookings, sizeof(bookings));
-                    close(pipe_fd[1]);
-                    exit(0);
-                } else {
-                    close(pipe_fd[1]);
-                    wait(NULL);
-                    read(pipe_fd[0], bookings, sizeof(bookings));
-                    close(pipe_fd[0]);
-                    printBookings("FCFS");
-                }
-
-                if (pipe(pipe_fd) == -1) {
-                    perror("Pipe creation failed");
-                    exit(1);
-                }
-                pid = fork();
-                if (pid < 0) {
-                    perror("Fork failed");
-                    exit(1);
-                }
-                if (pid == 0) {
-                    close(pipe_fd[0]);
-                    processBookings_Priority();
-                    write(pipe_fd[1], bookings, sizeof(bookings));
-                    close(pipe_fd[1]);
-                    exit(0);
-                } else {
-                    close(pipe_fd[1]);
-                    wait(NULL);
-                    read(pipe_fd[0], bookings, sizeof(bookings));
-                    close(pipe_fd[0]);
-                    printBookings("PRIORITY");
-                }
+                benchmarkOptimizer();
             } else {
                 printf("No booking(s) have been made.\n");
             }
-        } 
-        else if (strncmp(command, "addBatch", 8) == 0) {
-            char batchFile[20];
-            sscanf(command, "addBatch -%s", batchFile);
-            FILE *file = fopen(batchFile, "r");
-            if (file == NULL) {
-                printf("Cannot open batch file: %s\n", batchFile);
-                printf("-> [Pending]\n");
+        }
+        else if (strncmp(command, "setBayPolicy", 12) == 0) {
+            if (strcmp(command, "setBayPolicy -first") == 0) {
+                bayPolicy = BAY_FIRST_FIT;
+            } else if (strcmp(command, "setBayPolicy -best") == 0) {
+                bayPolicy = BAY_BEST_FIT;
+            } else if (strcmp(command, "setBayPolicy -lookahead") == 0) {
+                bayPolicy = BAY_LOOKAHEAD;
+            } else {
+                printf("Usage: setBayPolicy -first|-best|-lookahead\n");
                 continue;
             }
-            char line[128];
-            int lineNum = 0;
-            while (fgets(line, sizeof(line), file)) {
-                lineNum++;
-                line[strcspn(line, "\n")] = 0;
-                for (int i = 0; i < MAX_RESOURCES; i++) {
-                    strcpy(essentials[i], "");
-                }
-                if (strncmp(line, "addParking", 10) == 0) {
-                    sscanf(line, "addParking -%s %s %s %f %s %s %s %s %s %s %s",
-                           memberName, date, time, &duration, essentials[0], essentials[1], essentials[2],
-                           essentials[3], essentials[4], essentials[5], essentials[6]);
-                    if (!isValidMember(memberName)) {
-                        printf("Error in batch file %s at line %d: Invalid member name '%s'\n", batchFile, lineNum, memberName);
-                        continue;
-                    }
-                    if (!isValidDate(date)) {
-                        printf("Error in batch file %s at line %d: Invalid date '%s' (Expected: YYYY-MM-DD)\n", batchFile, lineNum, date);
-                        continue;
-                    }
-                    if (!isValidTime(time, duration)) {
-                        printf("Error in batch file %s at line %d: Invalid time '%s' (Expected: HH:MM) or invalid duration\n", batchFile, lineNum, time);
-                        continue;
-                    }
-                    for (int i = 0; i < MAX_RESOURCES && strlen(essentials[i]) > 0; i++) {
-                        if (!isValidResource(essentials[i])) {
-                            printf("Error in batch file %s at line %d: Invalid resource '%s'\n", batchFile, lineNum, essentials[i]);
-                            continue;
-                        }
-                    }
-                    addBooking(memberName, date, time, duration, essentials, PRIORITY_PARKING, 0);
-                    printf("-> [Pending] %s\n", line);
-                } else if (strncmp(line, "addReservation", 14) == 0) {
-                    sscanf(line, "addReservation -%s %s %s %f %s %s %s %s %s %s %s",
-                           memberName, date, time, &duration, essentials[0], essentials[1], essentials[2],
-                           essentials[3], essentials[4], essentials[5], essentials[6]);
-                    if (!isValidMember(memberName)) {
-                        printf("Error in batch file %s at line %d: Invalid member name '%s'\n", batchFile, lineNum, memberName);
-                        continue;
-                    }
-                    if (!isValidDate(date)) {
-                        printf("Error in batch file %s at line %d: Invalid date '%s' (Expected: YYYY-MM-DD)\n", batchFile, lineNum, date);
-                        continue;
-                    }
-                    if (!isValidTime(time, duration)) {
-                        printf("Error in batch file %s at line %d: Invalid time '%s' (Expected: HH:MM) or invalid duration\n", batchFile, lineNum, time);
-                        continue;
-                    }
-                    for (int i = 0; i < MAX_RESOURCES && strlen(essentials[i]) > 0; i++) {
-                        if (!isValidResource(essentials[i])) {
-                            printf("Error in batch file %s at line %d: Invalid resource '%s'\n", batchFile, lineNum, essentials[i]);
-                            continue;
-                        }
-                    }
-                    addBooking(memberName, date, time, duration, essentials, PRIORITY_RESERVATION, 0);
-                    printf("-> [Pending] %s\n", line);
-                } else if (strncmp(line, "addEvent", 8) == 0) {
-                    sscanf(line, "addEvent -%s %s %s %f %s %s %s %s %s %s %s",
-                           memberName, date, time, &duration, essentials[0], essentials[1], essentials[2],
-                           essentials[3], essentials[4], essentials[5], essentials[6]);
-                    if (!isValidMember(memberName)) {
-                        printf("Error in batch file %s at line %d: Invalid member name '%s'\n", batchFile, lineNum, memberName);
-                        continue;
-                    }
-                    if (!isValidDate(date)) {
-                        printf("Error in batch file %s at line %d: Invalid date '%s' (Expected: YYYY-MM-DD)\n", batchFile, lineNum, date);
-                        continue;
-                    }
-                    if (!isValidTime(time, duration)) {
-                        printf("Error in batch file %s at line %d: Invalid time '%s' (Expected: HH:MM) or invalid duration\n", batchFile, lineNum, time);
-                        continue;
-                    }
-                    for (int i = 0; i < MAX_RESOURCES && strlen(essentials[i]) > 0; i++) {
-                        if (!isValidResource(essentials[i])) {
-                            printf("Error in batch file %s at line %d: Invalid resource '%s'\n", batchFile, lineNum, essentials[i]);
-                            continue;
-                        }
-                    }
-                    addBooking(memberName, date, time, duration, essentials, PRIORITY_EVENT, 0);
-                    printf("-> [Pending] %s\n", line);
-                } else if (strncmp(line, "bookEssentials", 14) == 0) {
-                    sscanf(line, "bookEssentials -%s %s %s %f %s",
-                           memberName, date, time, &duration, essentials[0]);
-                    if (!isValidMember(memberName)) {
-                        printf("Error in batch file %s at line %d: Invalid member name '%s'\n", batchFile, lineNum, memberName);
-                        continue;
-                    }
-                    if (!isValidDate(date)) {
-                        printf("Error in batch file %s at line %d: Invalid date '%s' (Expected: YYYY-MM-DD)\n", batchFile, lineNum, date);
-                        continue;
-                    }
-                    if (!isValidTime(time, duration)) {
-                        printf("Error in batch file %s at line %d: Invalid time '%s' (Expected: HH:MM) or invalid duration\n", batchFile, lineNum, time);
-                        continue;
-                    }
-                    if (strlen(essentials[0]) > 0 && !isValidResource(essentials[0])) {
-                        printf("Error in batch file %s at line %d: Invalid resource '%s'\n", batchFile, lineNum, essentials[0]);
-                        continue;
-                    }
-                    addBooking(memberName, date, time, duration, essentials, PRIORITY_ESSENTIAL, 0);
-                    printf("-> [Pending] %s\n", line);
-                } else {
-                    printf("Error in batch file %s at line %d: Unrecognized command '%s'\n", batchFile, lineNum, line);
-                }
+            printf("Bay assignment policy set to %s.\n", getBayPolicyName(bayPolicy));
+        }
+        else if (strncmp(command, "setPreemption", 13) == 0) {
+            if (strcmp(command, "setPreemption -legacy") == 0) {
+                preemptionMode = PREEMPT_LEGACY;
+            } else if (strcmp(command, "setPreemption -cascade") == 0) {
+                preemptionMode = PREEMPT_CASCADE;
+            } else {
+                printf("Usage: setPreemption -legacy|-cascade\n");
+                continue;
+            }
+            printf("Preemption mode set to %s.\n", preemptionMode == PREEMPT_LEGACY ? "legacy" : "cascade");
+        }
+        else if (strncmp(command, "comparePreemption", 17) == 0) {
+            if (totalBookings > 0) {
+                comparePreemption();
+            } else {
+                printf("No booking(s) have been made.\n");
             }
-            fclose(file);
+        }
+        else if (strncmp(command, "stats", 5) == 0) {
+            printStats(stdout);
+#if SPMS_COUNTERS
+            if (strstr(command, "-reset") != NULL) memset(&stats, 0, sizeof(stats));
+#endif
+        }
+        else if (strncmp(command, "benchmarkSuite", 14) == 0) {
+            benchmarkSuite(command + 14);
+        }
+        else if (strncmp(command, "fuzzEngines", 11) == 0) {
+            fuzzEngines(command + 11);
+        }
+        else if (strncmp(command, "checkGolden", 11) == 0) {
+            checkGolden(command + 11);
+        }
+        else if (strncmp(command, "generateBatch", 13) == 0) {
+            const char *error = generateBatch(command + 13);
+            if (error != NULL) printf("%s\n", error);
+        }
+        else if (strncmp(command, "simulate", 8) == 0) {
+            simulate(command + 8);
         }
         else if (strncmp(command, "endProgram", 10) == 0) {
             printf("Bye!\n");
@@ -587,786 +1144,4193 @@ int main() {
     return 0;
 }
 
-void addBooking(char *memberName, char *date, char *time, float duration, char essentials[MAX_RESOURCES][20], int priority, int isEssentialBooking) {
-    if (totalBookings >= MAX_BOOKINGS) {
-        printf("Booking limit reached (Maximum: %i). Cannot create more bookings.\n", MAX_BOOKINGS);
-    } 
-    else {
-        Booking *b = &bookings[totalBookings];
-        strcpy(b->memberName, memberName);
-        strcpy(b->date, date);
-        strcpy(b->time, time);
-        b->duration = duration;
-        b->priority = priority;
-        b->parkingSlot = -1;
-        b->accepted = 0;
-        
-        int i;
-        for (i = 0; i < MAX_RESOURCES; i++) {
-            strcpy(b->essentials[i], essentials[i]);
-        }
-        
-        if (!isEssentialBooking) {
-            if (contains(b->essentials, "battery") >= 0 && contains(b->essentials, "cable") == -1) {
-                for (i = 0; i < MAX_RESOURCES; i++) {
-                    if (strcmp(essentials[i], "locker") == 0 || strcmp(essentials[i], "battery") == 0 || strcmp(essentials[i], "cable") == 0 || strcmp(essentials[i], "umbrella") == 0 || strcmp(essentials[i], "inflation") == 0 || strcmp(essentials[i], "valetpark") == 0) {
-                        continue;
-                    } else {
-                        strcpy(essentials[i], "cable");
-                        break;
-                    }
-                }
-            }
-            if (contains(b->essentials, "cable") >= 0 && contains(b->essentials, "battery") == -1) {
-                for (i = 0; i < MAX_RESOURCES; i++) {
-                    if (strcmp(essentials[i], "locker") == 0 || strcmp(essentials[i], "battery") == 0 || strcmp(essentials[i], "cable") == 0 || strcmp(essentials[i], "umbrella") == 0 || strcmp(essentials[i], "inflation") == 0 || strcmp(essentials[i], "valetpark") == 0) {
-                        continue;
-                    } else {
-                        strcpy(essentials[i], "battery");
-                        break;
-                    }
-                }  
-            }
-            if (contains(b->essentials, "locker") >= 0 && contains(b->essentials, "umbrella") == -1) {
-                for (i = 0; i < MAX_RESOURCES; i++) {
-                    if (strcmp(essentials[i], "locker") == 0 || strcmp(essentials[i], "battery") == 0 || strcmp(essentials[i], "cable") == 0 || strcmp(essentials[i], "umbrella") == 0 || strcmp(essentials[i], "inflation") == 0 || strcmp(essentials[i], "valetpark") == 0) {
-                        continue;
-                    } else {
-                        strcpy(essentials[i], "umbrella");
-                        break;
-                    }
-                }
-            }
-            if (contains(b->essentials, "umbrella") >= 0 && contains(b->essentials, "locker") == -1) {
-                for (i = 0; i < MAX_RESOURCES; i++) {
-                    if (strcmp(essentials[i], "locker") == 0 || strcmp(essentials[i], "battery") == 0 || strcmp(essentials[i], "cable") == 0 || strcmp(essentials[i], "umbrella") == 0 || strcmp(essentials[i], "inflation") == 0 || strcmp(essentials[i], "valetpark") == 0) {
-                        continue;
-                    } else {
-                        strcpy(essentials[i], "locker");
-                        break;
-                    }
-                }
-            } 
-            if (contains(b->essentials, "inflation") >= 0 && contains(b->essentials, "valetpark") == -1) {
-                for (i = 0; i < MAX_RESOURCES; i++) {
-                    if (strcmp(essentials[i], "locker") == 0 || strcmp(essentials[i], "battery") == 0 || strcmp(essentials[i], "cable") == 0 || strcmp(essentials[i], "umbrella") == 0 || strcmp(essentials[i], "inflation") == 0 || strcmp(essentials[i], "valetpark") == 0) {
-                        continue;
-                    } else {
-                        strcpy(essentials[i], "valetpark");
-                        break;
-                    }
-                }
-            }
-            if (contains(b->essentials, "valetpark") >= 0 && contains(b->essentials, "inflation") == -1) {
-                for (i = 0; i < MAX_RESOURCES; i++) {
-                    if (strcmp(essentials[i], "locker") == 0 || strcmp(essentials[i], "battery") == 0 || strcmp(essentials[i], "cable") == 0 || strcmp(essentials[i], "umbrella") == 0 || strcmp(essentials[i], "inflation") == 0 || strcmp(essentials[i], "valetpark") == 0) {
-                        continue;
-                    } else {
-                        strcpy(essentials[i], "inflation");
-                        break;
-                    }
-                }
-            }
-        }
-        totalBookings++;
-        initialBookings[totalBookings - 1] = *b;
-        printf("Booking added: %s on %s at %s for %.2f hours. ", memberName, date, time, duration);
-        printf("(");
-        for (i = 0; i < MAX_RESOURCES; i++) {
-            if (i > 0 && strlen(essentials[i]) > 0) printf(", ");
-            if (strcmp(essentials[i], "locker") == 0 || strcmp(essentials[i], "battery") == 0 || strcmp(essentials[i], "cable") == 0 || strcmp(essentials[i], "umbrella") == 0 || strcmp(essentials[i], "inflation") == 0 || strcmp(essentials[i], "valetpark") == 0) {
-                printf("%s", essentials[i]);
-            }
+// Site index of the " @name" token in the command, which is removed from it. SITE_ANY if there
+// is none, SITE_UNKNOWN if the name is not a site.
+int takeSitePreference(char *command) {
+    char *token = strstr(command, " @");
+    if (token == NULL) return SITE_ANY;
+    char name[20] = "";
+    sscanf(token + 2, "%19s", name);
+    char *rest = token + 2 + strcspn(token + 2, " ");
+    memmove(token, rest, strlen(rest) + 1);
+    for (int s = 0; s < siteCount; s++) {
+        if (strcmp(sites[s].name, name) == 0) return s;
+    }
+    return SITE_UNKNOWN;
+}
+
+// Adds a site, or changes the capacity of an existing one. Sites are fixed once bookings exist.
+const char* addSite(const char *command) {
+    char name[20] = "";
+    int bays, stock[MAX_RESOURCES] = {0}, length = 0;
+    int fields = sscanf(command, "addSite -%19s %d%n", name, &bays, &length);
+    for (int r = 0; fields >= 2 && r < essentialCount; r++) {
+        int used;
+        if (sscanf(command + length, "%d%n", &stock[r], &used) != 1) break;
+        length += used;
+        fields++;
+    }
+    if (fields != 3 && fields != 2 + essentialCount) return "Usage: addSite -name bays stock | addSite -name bays <stock of each essential>";
+    if (totalBookings > 0 || totalRules > 0) return "Sites must be set up before any booking is made";
+    if (bays < 0 || bays > MAX_BAYS) return "Invalid bay count (Expected: 0 to 128)";
+    for (int r = 0; r < essentialCount; r++) {
+        if (fields == 3) stock[r] = stock[0];
+        if (stock[r] < 0 || stock[r] > MAX_STOCK) return "Invalid stock (Expected: 0 to 8 of each essential)";
+    }
+    int s = 0;
+    while (s < siteCount && strcmp(sites[s].name, name) != 0) s++;
+    if (s == MAX_SITES) return "Site limit reached";
+    if (s == siteCount) siteCount++;
+    strcpy(sites[s].name, name);
+    sites[s].bays = bays;
+    memcpy(sites[s].stock, stock, sizeof(stock));
+    liveCalendars[s].site = s;
+    useCalendar(&liveCalendars[s]);
+    resetAvailability();
+    useCalendar(&passCalendar);
+    printf("Site %s: %d bays, stock", name, bays);
+    for (int r = 0; r < essentialCount; r++) printf(" %s %d", resourceNames[r], stock[r]);
+    printf("\n");
+    return NULL;
+}
+
+// 1 if the site has a bay (when the booking needs one) and enough stock of every essential it needs.
+int siteCanServe(int s, Booking *b, int demand[MAX_RESOURCES]) {
+    if (b->priority != PRIORITY_ESSENTIAL && sites[s].bays == 0) return 0;
+    for (int r = 0; r < MAX_RESOURCES; r++) {
+        if (demand[r] > sites[s].stock[r]) return 0;
+    }
+    return 1;
+}
+
+// Share of the site's daily capacity that would be taken with the booking added to what is
+// already there: bay-hours, or the busiest essential it needs if it needs no bay.
+float siteLoad(int s, Booking *b, int demand[MAX_RESOURCES], float bayHours, float resourceHours[MAX_RESOURCES]) {
+    float hours = durationToMinutes(b->duration) / 60.0;
+    float load = 0;
+    if (b->priority != PRIORITY_ESSENTIAL) load = (bayHours + hours) / (sites[s].bays * MINUTES_PER_DAY / 60.0);
+    for (int r = 0; r < MAX_RESOURCES; r++) {
+        if (demand[r] == 0) continue;
+        float share = (resourceHours[r] + hours * demand[r]) / (sites[s].stock[r] * MINUTES_PER_DAY / 60.0);
+        if (share > load) load = share;
+    }
+    return load;
+}
+
+// Writes the sites that can serve the booking into order, least loaded first, and returns how
+// many there are. load[] holds siteLoad of every site. A booking with a site preference only
+// ever goes to that site.
+int rankSites(Booking *b, int demand[MAX_RESOURCES], float load[MAX_SITES], int order[MAX_SITES]) {
+    if (b->site != SITE_ANY) {
+        order[0] = b->site;
+        return 1;
+    }
+    int count = 0;
+    for (int s = 0; s < siteCount; s++) {
+        if (!siteCanServe(s, b, demand)) continue;
+        int k = count++;
+        while (k > 0 && load[order[k - 1]] > load[s]) {
+            order[k] = order[k - 1];
+            k--;
         }
-        printf(")\n");
+        order[k] = s;
     }
+    return count;
 }
 
-void processBookings_FCFS() {
+// Gives every booking of the pass the site it is scheduled at. Bookings with a preference keep
+// it; the others go, in arrival order, to the least-loaded site that can serve them given what
+// has already been routed there on the same date. A booking no site can serve stays at the
+// first site and is rejected by the scheduler there.
+void routeBookings() {
+    PHASE_BEGIN(PHASE_ROUTE);
+    for (int i = 0; i < totalBookings; i++) {
+        bookings[i].assignedSite = bookings[i].site;
+    }
     for (int i = 0; i < totalBookings; i++) {
         Booking *b = &bookings[i];
-        int startMinutes = timeToMinutes(b->time);
-        int durationMinutes = durationToMinutes(b->duration);
-        int startSlot = startMinutes / 60;
-        int endSlot = (startMinutes + durationMinutes) / 60 + ((startMinutes + durationMinutes) % 60 > 0 ? 1 : 0);
-
-        int slotFound = -1;
-        if (b->priority != PRIORITY_ESSENTIAL) {
-            for (int j = 0; j < PARKING_SLOTS; j++) {
-                int available = 1;
-                for (int k = startSlot; k < endSlot; k++) {
-                    if (parkingAvailability[k][j] == 0) {
-                        available = 0;
-                        break;
-                    }
-                }
-                if (available) {
-                    slotFound = j;
-                    break;
-                }
+        if (b->site != SITE_ANY) continue;
+        int *demand = b->demand;
+
+        float load[MAX_SITES];
+        for (int s = 0; s < siteCount; s++) {
+            float bayHours = 0, resourceHours[MAX_RESOURCES] = {0};
+            for (int j = 0; j < totalBookings; j++) {
+                Booking *other = &bookings[j];
+                if (j == i || other->assignedSite != s || strcmp(other->date, b->date) != 0) continue;
+                float hours = durationToMinutes(other->duration) / 60.0;
+                if (other->priority != PRIORITY_ESSENTIAL) bayHours += hours;
+                for (int r = 0; r < MAX_RESOURCES; r++) resourceHours[r] += hours * other->demand[r];
             }
+            load[s] = siteLoad(s, b, demand, bayHours, resourceHours);
         }
+        int order[MAX_SITES];
+        b->assignedSite = rankSites(b, demand, load, order) > 0 ? order[0] : 0;
+    }
+    for (int i = 0; i < totalBookings; i++) {
+        initialBookings[i].assignedSite = bookings[i].assignedSite;
+    }
+    PHASE_END(PHASE_ROUTE);
+}
 
-        int resourcesAllocated = allocateResources(startMinutes, durationMinutes, b->essentials);
+int readAll(int fd, void *buffer, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t got = read(fd, (char *)buffer + done, size - done);
+        if (got <= 0) return 0;
+        done += got;
+    }
+    return 1;
+}
 
-        if (b->priority == PRIORITY_ESSENTIAL) {
-            if (resourcesAllocated) {
-                b->accepted = 1;
-            } else {
-                b->accepted = 0;
-                snprintf(b->reasonForRejection, sizeof(b->reasonForRejection), "One or more essentials unavailable.");
-                suggestAlternativeSlots(b->duration, b->memberName, b->date, b->time);
-            }
-        } else {
-            if (slotFound != -1 && resourcesAllocated) {
-                for (int k = startSlot; k < endSlot; k++) {
-                    parkingAvailability[k][slotFound] = 0;
-                }
-                b->parkingSlot = slotFound;
-                b->accepted = 1;
-            } else if (slotFound == -1) {
-                // Try to displace lower-priority bookings
-                for (int j = 0; j < totalBookings; j++) {
-                    Booking *other = &bookings[j];
-                    if (other != b && other->accepted && other->priority > b->priority &&
-                        strcmp(other->date, b->date) == 0) {
-                        int otherStart = timeToMinutes(other->time);
-                        int otherDuration = durationToMinutes(other->duration);
-                        int otherEnd = otherStart + otherDuration;
-                        if (startMinutes < otherEnd && otherStart < (startMinutes + durationMinutes)) {
-                            releaseResources(otherStart, otherDuration, other->essentials);
-                            int otherEndSlot = (otherStart + otherDuration) / 60 + ((otherStart + otherDuration) % 60 > 0 ? 1 : 0);
-                            for (int k = otherStart / 60; k < otherEndSlot; k++) {
-                                parkingAvailability[k][other->parkingSlot] = 1;
-                            }
-                            other->accepted = 0;
-                            snprintf(other->reasonForRejection, sizeof(other->reasonForRejection),
-                                     "Displaced by higher priority booking.");
-                            slotFound = other->parkingSlot;
-                            break;
-                        }
-                    }
-                }
-                if (slotFound != -1 && (resourcesAllocated || (resourcesAllocated = allocateResources(startMinutes, durationMinutes, b->essentials)))) {
-                    for (int k = startSlot; k < endSlot; k++) {
-                        parkingAvailability[k][slotFound] = 0;
-                    }
-                    b->parkingSlot = slotFound;
-                    b->accepted = 1;
-                } else {
-                    releaseResources(startMinutes, durationMinutes, b->essentials);
-                    b->accepted = 0;
-                    snprintf(b->reasonForRejection, sizeof(b->reasonForRejection),
-                             resourcesAllocated ? "No available parking slots." : "One or more essentials unavailable.");
-                    suggestAlternativeSlots(b->duration, b->memberName, b->date, b->time);
-                }
-            } else {
-                releaseResources(startMinutes, durationMinutes, b->essentials);
-                b->accepted = 0;
-                snprintf(b->reasonForRejection, sizeof(b->reasonForRejection), "One or more essentials unavailable.");
-                suggestAlternativeSlots(b->duration, b->memberName, b->date, b->time);
+// The record a site child sends back for a booking (see BookingRecord).
+BookingRecord packBooking(const Booking *b) {
+    BookingRecord record;
+    memset(&record, 0, sizeof(record));
+    record.day = dateToDay(b->date);
+    record.passIndex = b->passIndex;
+    record.startMinute = timeToMinutes((char *)b->time);
+    record.durationMinutes = durationToMinutes(b->duration);
+    record.slot = b->parkingSlot;
+    for (int m = 0; m < 5; m++) {
+        if (strcmp(members[m], b->memberName) == 0) record.member = m;
+    }
+    record.priority = b->priority;
+    for (int r = 0; r < MAX_RESOURCES; r++) {
+        if (b->demand[r] > 0) record.resourceMask |= 1 << r;
+    }
+    record.status = b->accepted;
+    record.reason = b->reason;
+    record.site = b->assignedSite;
+    return record;
+}
+
+// Writes the outcome in a record over the booking it was packed from.
+void unpackBooking(const BookingRecord *record, Booking *b) {
+    b->passIndex = record->passIndex;
+    b->accepted = record->status;
+    b->reason = record->reason;
+    b->parkingSlot = record->slot;
+    b->assignedSite = record->site;
+    if (record->startMinute != timeToMinutes(b->time)) {
+        snprintf(b->time, sizeof(b->time), "%02d:%02d", record->startMinute / 60 % 24, record->startMinute % 60);
+    }
+}
+
+// Runs the scheduler once per site, each in its own child process so sites are scheduled in
+// parallel, and gathers the schedules back into bookings[] site by site. What the children print
+// (suggestions) is replayed in site order. fragmentation[], if given, gets each site's bay
+// fragmentation.
+void scheduleSites(void (*scheduler)(), float fragmentation[]) {
+    PHASE_BEGIN(PHASE_SCHEDULE);
+    int pipes[MAX_SITES][2];
+    FILE *output[MAX_SITES];
+    pid_t pids[MAX_SITES];
+    double forkCall[MAX_SITES], forkReturn[MAX_SITES], scheduleStart = nowMs();
+    fflush(stdout); // otherwise the children flush a copy of pending output again
+    for (int s = 0; s < siteCount; s++) {
+        output[s] = tmpfile();
+        if (pipe(pipes[s]) == -1 || output[s] == NULL) {
+            perror("Pipe creation failed");
+            exit(1);
+        }
+        forkCall[s] = nowMs();
+        pids[s] = fork();
+        if (pids[s] < 0) {
+            perror("Fork failed");
+            exit(1);
+        }
+        if (pids[s] == 0) {
+            SiteTrace trace;
+            trace.started = nowMs();
+            close(pipes[s][0]);
+            dup2(fileno(output[s]), STDOUT_FILENO);
+            int n = 0;
+            for (int i = 0; i < totalBookings; i++) {
+                bookings[i].passIndex = i;
+                bookings[i].suggestPending = 0;
+                if (bookings[i].assignedSite == s) bookings[n++] = bookings[i];
             }
+            totalBookings = n;
+            calendar->site = s;
+            resetAvailability();
+#if SPMS_COUNTERS
+            memset(&stats, 0, sizeof(stats)); // send back only what this child counted
+#endif
+            trace.computeStart = nowMs();
+            if (n > 0) scheduler();
+            trace.computeEnd = nowMs();
+            if (suggestionsEnabled) printPendingSuggestions();
+            float siteFragmentation = bayFragmentation();
+            fflush(stdout);
+            trace.suggestEnd = trace.writeStart = nowMs();
+            write(pipes[s][1], &trace, sizeof(trace));
+            write(pipes[s][1], &siteFragmentation, sizeof(siteFragmentation));
+            write(pipes[s][1], &n, sizeof(n));
+            static BookingRecord records[MAX_PASS_BOOKINGS];
+            for (int i = 0; i < n; i++) records[i] = packBooking(&bookings[passOrder[i]]); // schedules come back in pass order
+            write(pipes[s][1], records, n * sizeof(BookingRecord));
+#if SPMS_COUNTERS
+            write(pipes[s][1], &stats, sizeof(stats));
+#endif
+            close(pipes[s][1]);
+            exit(0);
+        }
+        forkReturn[s] = nowMs();
+        close(pipes[s][1]);
+    }
+
+    static Booking sent[MAX_PASS_BOOKINGS]; // the children's copy, what their records refer to
+    static BookingRecord records[MAX_PASS_BOOKINGS];
+    memcpy(sent, bookings, totalBookings * sizeof(Booking));
+    int gathered = 0;
+    lastComputeMs = 0;
+    for (int s = 0; s < siteCount; s++) {
+        float siteFragmentation = 0;
+        int n = 0;
+        SiteTrace trace = {0};
+        double readStart = nowMs();
+        if (!readAll(pipes[s][0], &trace, sizeof(trace)) ||
+            !readAll(pipes[s][0], &siteFragmentation, sizeof(siteFragmentation)) || !readAll(pipes[s][0], &n, sizeof(n)) ||
+            n < 0 || n > MAX_PASS_BOOKINGS - gathered || !readAll(pipes[s][0], records, n * sizeof(BookingRecord))) {
+            printf("Scheduling of site %s failed.\n", sites[s].name);
+            n = 0;
+        }
+        for (int i = 0; i < n; i++) {
+            bookings[gathered + i] = sent[records[i].passIndex];
+            unpackBooking(&records[i], &bookings[gathered + i]);
+        }
+#if SPMS_COUNTERS
+        Stats childStats;
+        if (readAll(pipes[s][0], &childStats, sizeof(childStats))) mergeStats(&childStats);
+        int algorithm = usageIndex(scheduler) != -1 ? usageIndex(scheduler) : 3;
+        stats.scheduled[algorithm] += n;
+        for (int i = gathered; i < gathered + n; i++) stats.accepted[algorithm] += bookings[i].accepted;
+#endif
+        double readEnd = nowMs();
+        gathered += n;
+        if (fragmentation != NULL) fragmentation[s] = siteFragmentation;
+        close(pipes[s][0]);
+        waitpid(pids[s], NULL, 0);
+        double waitEnd = nowMs();
+
+        char chunk[4096];
+        size_t length;
+        rewind(output[s]);
+        while ((length = fread(chunk, 1, sizeof(chunk), output[s])) > 0) {
+            fwrite(chunk, 1, length, stdout);
+        }
+        fclose(output[s]);
+
+        // Transfer runs from when both ends are at the pipe; the parent waits before and after it.
+        double transferStart = trace.writeStart > readStart ? trace.writeStart : readStart;
+        double compute = trace.computeEnd - trace.computeStart;
+        if (compute > lastComputeMs) lastComputeMs = compute;
+        if (traceEnabled) {
+            fflush(stdout);
+            fprintf(stderr, "[trace] %s site %s: fork %.3f, startup %.3f, compute %.3f, suggestions %.3f, transfer %.3f (%zu bytes), "
+                    "wait %.3f, replay %.3f ms\n", schedulerName(scheduler), sites[s].name,
+                    forkReturn[s] - forkCall[s], trace.started - forkCall[s], compute, trace.suggestEnd - trace.computeEnd,
+                    readEnd - transferStart,
+                    sizeof(trace) + sizeof(float) + sizeof(int) + n * sizeof(BookingRecord),
+                    (transferStart - readStart) + (waitEnd - readEnd), nowMs() - waitEnd);
         }
     }
+    lastScheduleMs = nowMs() - scheduleStart;
+    PHASE_END(PHASE_SCHEDULE);
 }
 
-void processBookings_Priority() {
-    qsort(bookings, totalBookings, sizeof(Booking), compareBookings);
+float meanFragmentation(float fragmentation[MAX_SITES]) {
+    float sum = 0;
+    for (int s = 0; s < siteCount; s++) sum += fragmentation[s];
+    return sum / siteCount;
+}
+
+// Slot of passUsage for a scheduler, -1 if it is not one the summary report covers.
+int usageIndex(void (*scheduler)()) {
+    if (scheduler == processBookings_FCFS) return 0;
+    if (scheduler == processBookings_Priority) return 1;
+    if (scheduler == processBookings_Optimized) return 2;
+    return -1;
+}
+
+const char* schedulerName(void (*scheduler)()) {
+    const char *names[3] = {"FCFS", "PRIORITY", "OPTIMIZED"};
+    return usageIndex(scheduler) != -1 ? names[usageIndex(scheduler)] : "other";
+}
+
+void mergeStats(const Stats *child) {
+#if SPMS_COUNTERS
+    stats.allocateCalls += child->allocateCalls;
+    stats.allocateFailures += child->allocateFailures;
+    stats.releaseCalls += child->releaseCalls;
+    stats.baySearches += child->baySearches;
+    stats.bayProbes += child->bayProbes;
+    stats.displacements += child->displacements;
+    stats.suggestionCalls += child->suggestionCalls;
+    stats.suggestionProbes += child->suggestionProbes;
+    stats.suggestionCacheHits += child->suggestionCacheHits;
+    stats.preemptionSearches += child->preemptionSearches;
+    stats.preemptionProbes += child->preemptionProbes;
+    for (int a = 0; a < 4; a++) {
+        stats.scheduled[a] += child->scheduled[a];
+        stats.accepted[a] += child->accepted[a];
+    }
+    for (int p = 0; p < PHASE_COUNT; p++) stats.phaseMs[p] += child->phaseMs[p];
+#else
+    (void)child;
+#endif
+}
+
+void printStats(FILE *out) {
+#if SPMS_COUNTERS
+    const char *algorithms[4] = {"FCFS", "PRIORITY", "OPTIMIZED", "other"};
+    const char *phases[PHASE_COUNT] = {"ingest", "route", "schedule", "report", "summary"};
+    fprintf(out, "\n*** Counters (this process and its site children) ***\n");
+    fprintf(out, "allocateResources: %ld calls, %ld failed\n", stats.allocateCalls, stats.allocateFailures);
+    fprintf(out, "releaseResources: %ld calls\n", stats.releaseCalls);
+    fprintf(out, "Bay searches: %ld, probes: %ld\n", stats.baySearches, stats.bayProbes);
+    fprintf(out, "Displacements: %ld\n", stats.displacements);
+    fprintf(out, "Suggestions: %ld calls, %ld probes, %ld cache hits\n", stats.suggestionCalls, stats.suggestionProbes, stats.suggestionCacheHits);
+    fprintf(out, "Preemption start searches: %ld, probes: %ld\n", stats.preemptionSearches, stats.preemptionProbes);
+    for (int a = 0; a < 4; a++) {
+        fprintf(out, "Scheduled by %s: %ld (%ld accepted)\n", algorithms[a], stats.scheduled[a], stats.accepted[a]);
+    }
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        fprintf(out, "Time in %s: %.3f ms\n", phases[p], stats.phaseMs[p]);
+    }
+#else
+    fprintf(out, "Counters were compiled out (SPMS_COUNTERS=0).\n");
+#endif
+}
+
+// Registered at startup when SPMS_STATS is set.
+void dumpStatsAtExit() {
+    if (getpid() == mainPid) printStats(stderr);
+}
+
+// Accumulates, in one pass over the schedule in bookings[], what the accepted bookings occupy:
+// bay-minutes per site, essential-minutes per essential, and both per booked date and hour.
+void recordUsage(PassUsage *usage, float fragmentation[MAX_SITES]) {
+    memset(usage, 0, sizeof(*usage));
+    usage->recorded = 1;
+    usage->fragmentation = meanFragmentation(fragmentation);
+    for (int i = 0; i < totalBookings; i++) {
+        int day = dateToDay(bookings[i].date);
+        int position = 0;
+        while (position < usage->dateCount && usage->dates[position] < day) position++;
+        if (position < usage->dateCount && usage->dates[position] == day) continue;
+        memmove(&usage->dates[position + 1], &usage->dates[position], (usage->dateCount - position) * sizeof(int));
+        usage->dates[position] = day;
+        usage->dateCount++;
+    }
+    if (usage->dateCount > 0) {
+        usage->firstDay = usage->dates[0];
+        usage->lastDay = usage->dates[usage->dateCount - 1];
+    }
+
     for (int i = 0; i < totalBookings; i++) {
         Booking *b = &bookings[i];
+        if (!b->accepted) continue;
+        usage->accepted++;
+        if (b->reason == REASON_MOVED) usage->moved++;
+        int day = dateToDay(b->date), d = 0;
+        while (usage->dates[d] != day) d++;
         int startMinutes = timeToMinutes(b->time);
-        int durationMinutes = durationToMinutes(b->duration);
-        int startSlot = startMinutes / 60;
-        int endSlot = (startMinutes + durationMinutes) / 60 + ((startMinutes + durationMinutes) % 60 > 0 ? 1 : 0);
-
-        int slotFound = -1;
-        if (b->priority != PRIORITY_ESSENTIAL) {
-            for (int j = 0; j < PARKING_SLOTS; j++) {
-                int available = 1;
-                for (int k = startSlot; k < endSlot; k++) {
-                    if (parkingAvailability[k][j] == 0) {
-                        available = 0;
-                        break;
-                    }
-                }
-                if (available) {
-                    slotFound = j;
-                    break;
-                }
-            }
+        int endMinutes = startMinutes + durationToMinutes(b->duration);
+        if (endMinutes > MINUTES_PER_DAY) endMinutes = MINUTES_PER_DAY; // cut at midnight
+        int essentials = 0;
+        for (int r = 0; r < MAX_RESOURCES; r++) {
+            usage->resourceMinutes[r] += b->demand[r] * (endMinutes - startMinutes);
+            essentials += b->demand[r];
         }
+        int bays = b->priority != PRIORITY_ESSENTIAL;
+        usage->bayMinutes[b->assignedSite] += bays * (endMinutes - startMinutes);
+        for (int hour = startMinutes / 60; hour * 60 < endMinutes; hour++) {
+            int from = hour * 60 > startMinutes ? hour * 60 : startMinutes;
+            int to = (hour + 1) * 60 < endMinutes ? (hour + 1) * 60 : endMinutes;
+            usage->bayHeat[d][hour] += bays * (to - from);
+            usage->essentialHeat[d][hour] += essentials * (to - from);
+        }
+    }
+}
 
-        int resourcesAllocated = allocateResources(startMinutes, durationMinutes, b->essentials);
-
-        if (b->priority == PRIORITY_ESSENTIAL) {
-            if (resourcesAllocated) {
-                b->accepted = 1;
-            } else {
-                b->accepted = 0;
-                snprintf(b->reasonForRejection, sizeof(b->reasonForRejection), "One or more essentials unavailable.");
-                suggestAlternativeSlots(b->duration, b->memberName, b->date, b->time);
-            }
-        } else {
-            if (slotFound != -1 && resourcesAllocated) {
-                for (int k = startSlot; k < endSlot; k++) {
-                    parkingAvailability[k][slotFound] = 0;
-                }
-                b->parkingSlot = slotFound;
-                b->accepted = 1;
-            } else if (slotFound == -1) {
-                for (int j = 0; j < totalBookings; j++) {
-                    Booking *other = &bookings[j];
-                    if (other != b && other->accepted && other->priority > b->priority &&
-                        strcmp(other->date, b->date) == 0) {
-                        int otherStart = timeToMinutes(other->time);
-                        int otherDuration = durationToMinutes(other->duration);
-                        int otherEnd = otherStart + otherDuration;
-                        if (startMinutes < otherEnd && otherStart < (startMinutes + durationMinutes)) {
-                            releaseResources(otherStart, otherDuration, other->essentials);
-                            int otherEndSlot = (otherStart + otherDuration) / 60 + ((otherStart + otherDuration) % 60 > 0 ? 1 : 0);
-                            for (int k = otherStart / 60; k < otherEndSlot; k++) {
-                                parkingAvailability[k][other->parkingSlot] = 1;
-                            }
-                            other->accepted = 0;
-                            snprintf(other->reasonForRejection, sizeof(other->reasonForRejection),
-                                     "Displaced by higher priority booking.");
-                            slotFound = other->parkingSlot;
-                            break;
-                        }
-                    }
-                }
-                if (slotFound != -1 && (resourcesAllocated || (resourcesAllocated = allocateResources(startMinutes, durationMinutes, b->essentials)))) {
-                    for (int k = startSlot; k < endSlot; k++) {
-                        parkingAvailability[k][slotFound] = 0;
-                    }
-                    b->parkingSlot = slotFound;
-                    b->accepted = 1;
-                } else {
-                    releaseResources(startMinutes, durationMinutes, b->essentials);
-                    b->accepted = 0;
-                    snprintf(b->reasonForRejection, sizeof(b->reasonForRejection),
-                             resourcesAllocated ? "No available parking slots." : "One or more essentials unavailable.");
-                    suggestAlternativeSlots(b->duration, b->memberName, b->date, b->time);
-                }
-            } else {
-                releaseResources(startMinutes, durationMinutes, b->essentials);
-                b->accepted = 0;
-                snprintf(b->reasonForRejection, sizeof(b->reasonForRejection), "One or more essentials unavailable.");
-                suggestAlternativeSlots(b->duration, b->memberName, b->date, b->time);
+// One row per booked date, one cell per hour: the tens digit of the share of bays (left) and of
+// essential stock (right) occupied in that hour, '.' for none and '#' for all.
+void printHeatmap(PassUsage *usage, const char *algorithm) {
+    float bays = 0, stock = 0;
+    for (int s = 0; s < siteCount; s++) {
+        bays += sites[s].bays;
+        for (int r = 0; r < essentialCount; r++) stock += sites[s].stock[r];
+    }
+    printf("Hourly Occupancy (%s, bays | essentials, 0-9 = tens of percent, # = full):\n", algorithm);
+    printf("    %-10s %-24s   %-24s\n", "Date", "0h    6h    12h   18h", "0h    6h    12h   18h");
+    for (int d = 0; d < usage->dateCount; d++) {
+        char date[11], cells[2][USAGE_HOURS + 1];
+        dayToDate(usage->dates[d], date);
+        for (int hour = 0; hour < USAGE_HOURS; hour++) {
+            float share[2] = {bays > 0 ? usage->bayHeat[d][hour] / (bays * 60) : 0,
+                              stock > 0 ? usage->essentialHeat[d][hour] / (stock * 60) : 0};
+            for (int k = 0; k < 2; k++) {
+                if (share[k] <= 0) cells[k][hour] = '.';
+                else if (share[k] >= 1) cells[k][hour] = '#';
+                else cells[k][hour] = '0' + (int)(share[k] * 10);
             }
         }
+        cells[0][USAGE_HOURS] = cells[1][USAGE_HOURS] = '\0';
+        printf("    %-10s %s | %s\n", date, cells[0], cells[1]);
     }
 }
 
-void processBookings_Optimized() {
-    // Step 1: Run FCFS to get initial allocation
-    processBookings_FCFS();
+// Booking and live entry of live row i: a one-off booking below OCCURRENCE_ROW, a live recurring
+// occurrence from there on. The waitlist works on these rows.
+Booking *liveBooking(int i) {
+    return i < OCCURRENCE_ROW ? &initialBookings[i] : &liveOccurrences[i - OCCURRENCE_ROW].booking;
+}
 
-    // Save initial state
-    int tempParking[TIME_SLOTS][PARKING_SLOTS];
-    int tempResources[TIME_SLOTS][MAX_RESOURCES];
-    memcpy(tempParking, parkingAvailability, sizeof(parkingAvailability));
-    memcpy(tempResources, resourceAvailability, sizeof(resourceAvailability));
+LiveEntry *liveEntry(int i) {
+    return i < OCCURRENCE_ROW ? &liveEntries[i] : &liveOccurrences[i - OCCURRENCE_ROW].entry;
+}
 
-    // Step 2: Process rejected bookings with optimization
-    for (int m = 0; m < 5; m++) {
-        const char *member = members[m];
-        int rejectedBookings[MAX_BOOKINGS];
-        int rejectedCount = 0;
+// Admits live row i into the live calendar of the least-loaded site (on its date) where a bay and
+// its essentials are free, otherwise leaves it waiting. A one-off booking first has the recurring
+// occurrences of its date expanded, so it competes with them. Returns 1 if it was admitted.
+int admitLive(int i) {
+    if (i < OCCURRENCE_ROW && !expandLiveDays(dateToDay(initialBookings[i].date), dateToDay(initialBookings[i].date))) {
+        printf("Too many recurring occurrences held live (Maximum: %d). Those on %s are left to the passes.\n",
+               MAX_OCCURRENCES, initialBookings[i].date);
+    }
+    return placeLive(liveBooking(i), liveEntry(i));
+}
 
-        for (int i = 0; i < totalBookings; i++) {
-            Booking *b = &bookings[i];
-            if (strcmp(b->memberName, member) == 0 && !b->accepted) {
-                rejectedBookings[rejectedCount++] = i;
-            }
+// Admits b into the live calendars as admitLive describes and records where in entry.
+int placeLive(Booking *b, LiveEntry *entry) {
+    Calendar *savedCalendar = calendar;
+    int startMinutes = timeToMinutes(b->time);
+    int durationMinutes = durationToMinutes(b->duration);
+    int startSlot = startMinutes / slotMinutes;
+    int endSlot = slotEnd(startMinutes, durationMinutes);
+    int *demand = b->demand;
+
+    float load[MAX_SITES];
+    for (int s = 0; s < siteCount; s++) {
+        useCalendar(&liveCalendars[s]);
+        selectDay(b->date);
+        float bayHours = 0, resourceHours[MAX_RESOURCES] = {0};
+        for (int k = 0; k < timeSlots; k++) {
+            for (int j = 0; j < sites[s].bays; j++) bayHours += (parkingAvailability[k][j] == 0) * slotMinutes / 60.0;
+            for (int r = 0; r < MAX_RESOURCES; r++) resourceHours[r] += (sites[s].stock[r] - resourceAvailability[k][r]) * slotMinutes / 60.0;
         }
+        load[s] = siteLoad(s, b, demand, bayHours, resourceHours);
+    }
+    int order[MAX_SITES];
+    int candidates = rankSites(b, demand, load, order);
 
-        if (rejectedCount > 0) {
-            int durationMinutes = durationToMinutes(bookings[rejectedBookings[0]].duration);
-            int processed = 0;
+    entry->bay = -1;
+    entry->status = LIVE_WAITING;
+    schedulingIndex = totalBookings; // nothing is pending in the live calendars
+    for (int c = 0; c < candidates && entry->status != LIVE_ADMITTED; c++) {
+        useCalendar(&liveCalendars[order[c]]);
+        selectDay(b->date);
+        int bay = -1;
+        if (b->priority != PRIORITY_ESSENTIAL) bay = chooseBay(b, startSlot, endSlot);
+        if ((b->priority == PRIORITY_ESSENTIAL || bay != -1) && allocateResources(startMinutes, durationMinutes, b->demand)) {
+            if (bay != -1) setBayRange(startSlot, endSlot, bay, 0);
+            entry->site = order[c];
+            entry->bay = bay;
+            entry->status = LIVE_ADMITTED;
+        }
+    }
+    useCalendar(savedCalendar);
+    return entry->status == LIVE_ADMITTED;
+}
 
-            for (int startMinutes = 0; startMinutes <= 1440 - durationMinutes && processed < rejectedCount; startMinutes += 60) {
-                memcpy(parkingAvailability, tempParking, sizeof(parkingAvailability));
-                memcpy(resourceAvailability, tempResources, sizeof(resourceAvailability));
+// Gives back the bay and essentials live row i holds in the live calendar. Returns the
+// waitlist mask of what was freed (0 if the booking held nothing).
+int releaseLive(int i) {
+    Booking *b = liveBooking(i);
+    LiveEntry *entry = liveEntry(i);
+    if (entry->status != LIVE_ADMITTED) return 0;
+    int freedMask = waitKeyOf(i).mask;
+    Calendar *savedCalendar = calendar;
+    useCalendar(&liveCalendars[entry->site]);
+    selectDay(b->date);
 
-                for (int j = 0; j < totalBookings; j++) {
-                    if (bookings[j].accepted) {
-                        int start = timeToMinutes(bookings[j].time);
-                        int dur = durationToMinutes(bookings[j].duration);
-                        allocateResources(start, dur, bookings[j].essentials);
-                        if (bookings[j].priority != PRIORITY_ESSENTIAL) {
-                            int sSlot = start / 60;
-                            int eSlot = (start + dur) / 60 + ((start + dur) % 60 > 0 ? 1 : 0);
-                            for (int k = sSlot; k < eSlot; k++) {
-                                parkingAvailability[k][bookings[j].parkingSlot] = 0;
+    int startMinutes = timeToMinutes(b->time);
+    int durationMinutes = durationToMinutes(b->duration);
+    releaseResources(startMinutes, durationMinutes, b->demand);
+    if (entry->bay != -1) setBayRange(startMinutes / slotMinutes, slotEnd(startMinutes, durationMinutes), entry->bay, 1);
+    if (entry->bay == -1) freedMask &= ~WAIT_NEEDS_BAY;
+    entry->bay = -1;
+    entry->status = LIVE_WAITING;
+    useCalendar(savedCalendar);
+    return freedMask;
+}
+
+// Position of the first live occurrence not below (day, rule).
+int occurrencePosition(int day, int rule) {
+    int low = 0, high = liveOccurrenceCount;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        LiveOccurrence *occurrence = &liveOccurrences[mid];
+        if (occurrence->day < day || (occurrence->day == day && occurrence->rule < rule)) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+// Works out the occurrences of every rule from fromDay to toDay that the live calendars do not
+// hold yet and admits them like one-off bookings; one that does not fit waits on the waitlist.
+// Days past the horizon or before the last expiry are skipped. Returns 0 if the table is full.
+int expandLiveDays(int fromDay, int toDay) {
+    if (totalRules == 0) return 1;
+    if (fromDay < liveCutoffDay) fromDay = liveCutoffDay;
+    if (horizonDays > 0 && toDay > todayDay() + horizonDays) toDay = todayDay() + horizonDays;
+    int position = occurrencePosition(fromDay, 0);
+    for (int day = fromDay; day <= toDay; day++) {
+        for (int r = 0; r < totalRules; r++) {
+            RecurrenceRule *rule = &recurrenceRules[r];
+            if (recurrenceOccurrence(rule, day) < 0) continue;
+            while (position < liveOccurrenceCount && (liveOccurrences[position].day < day ||
+                   (liveOccurrences[position].day == day && liveOccurrences[position].rule < r))) position++;
+            if (position < liveOccurrenceCount && liveOccurrences[position].day == day && liveOccurrences[position].rule == r) {
+                position++;
+                continue;
+            }
+            if (liveOccurrenceCount == MAX_OCCURRENCES) return 0;
+            memmove(&liveOccurrences[position + 1], &liveOccurrences[position], (liveOccurrenceCount - position) * sizeof(LiveOccurrence));
+            liveOccurrenceCount++;
+            LiveOccurrence *occurrence = &liveOccurrences[position];
+            char date[11];
+            dayToDate(day, date);
+            occurrence->rule = r;
+            occurrence->day = day;
+            occurrenceBooking(rule, date, &occurrence->booking);
+            occurrence->entry.handle = nextOccurrenceHandle--;
+            if (!placeLive(&occurrence->booking, &occurrence->entry)) {
+                enqueueWaiting(OCCURRENCE_ROW + position);
+                waitlistedCount++;
+                printf("Recurring booking of %s on %s at %s is waiting: no bay or essentials free.\n",
+                       rule->memberName, date, rule->time);
+            }
+            position++;
+        }
+    }
+    return 1;
+}
+
+// Drops the live occurrences of the rules flagged in retired[] and those dated before cutoffDay,
+// giving back what they hold or taking them off the waitlist. retired[] is indexed like
+// recurrenceRules before removal; remap[] gives each kept rule's new index.
+void dropOccurrences(const int retired[], const int remap[], int cutoffDay) {
+    int kept = 0;
+    for (int o = 0; o < liveOccurrenceCount; o++) {
+        LiveOccurrence *occurrence = &liveOccurrences[o];
+        if (retired[occurrence->rule] || occurrence->day < cutoffDay) {
+            if (occurrence->entry.status == LIVE_WAITING) dequeueWaiting(OCCURRENCE_ROW + o);
+            releaseLive(OCCURRENCE_ROW + o);
+            continue;
+        }
+        occurrence->rule = remap[occurrence->rule];
+        liveOccurrences[kept++] = *occurrence;
+    }
+    liveOccurrenceCount = kept;
+    if (cutoffDay > liveCutoffDay) liveCutoffDay = cutoffDay;
+}
+
+// Live row of a handle (see liveBooking), or -1 if it is gone.
+int findLiveRow(int handle) {
+    if (handle > 0) return findBookingByHandle(handle);
+    for (int o = 0; o < liveOccurrenceCount; o++) {
+        if (liveOccurrences[o].entry.handle == handle) return OCCURRENCE_ROW + o;
+    }
+    return -1;
+}
+
+// Handles only grow, so liveEntries stays sorted by handle and can be binary searched.
+int findBookingByHandle(int handle) {
+    int low = 0, high = totalBookings - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        if (liveEntries[mid].handle == handle) return liveEntries[mid].status == LIVE_CANCELLED ? -1 : mid;
+        if (liveEntries[mid].handle < handle) low = mid + 1;
+        else high = mid - 1;
+    }
+    return -1;
+}
+
+WaitKey waitKeyOf(int i) {
+    Booking *b = liveBooking(i);
+    int startMinutes = timeToMinutes(b->time);
+    WaitKey key = {dateToDay(b->date), startMinutes / slotMinutes, 0, 0, liveEntry(i)->handle};
+    key.slots = slotEnd(startMinutes, durationToMinutes(b->duration)) - key.startSlot;
+    for (int r = 0; r < MAX_RESOURCES; r++) {
+        if (b->demand[r]) key.mask |= 1 << r;
+    }
+    if (b->priority != PRIORITY_ESSENTIAL) key.mask |= WAIT_NEEDS_BAY;
+    return key;
+}
+
+int compareWaitKeys(const WaitKey *a, const WaitKey *b) {
+    if (a->day != b->day) return a->day < b->day ? -1 : 1;
+    if (a->startSlot != b->startSlot) return a->startSlot - b->startSlot;
+    if (a->slots != b->slots) return a->slots - b->slots;
+    if (a->mask != b->mask) return a->mask - b->mask;
+    return a->handle - b->handle;
+}
+
+// Position of the first waitlist key not below the given one.
+int waitPosition(const WaitKey *key) {
+    int low = 0, high = waitCount;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (compareWaitKeys(&waitlist[mid], key) < 0) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+void enqueueWaiting(int i) {
+    WaitKey key = waitKeyOf(i);
+    int position = waitPosition(&key);
+    memmove(&waitlist[position + 1], &waitlist[position], (waitCount - position) * sizeof(WaitKey));
+    waitlist[position] = key;
+    waitCount++;
+    if (key.slots > waitLongest) waitLongest = key.slots;
+}
+
+// Removes live row i from the waitlist; its date, time and duration must be those it waited with.
+void dequeueWaiting(int i) {
+    WaitKey key = waitKeyOf(i);
+    int position = waitPosition(&key);
+    if (position == waitCount || compareWaitKeys(&waitlist[position], &key) != 0) return;
+    memmove(&waitlist[position], &waitlist[position + 1], (waitCount - position - 1) * sizeof(WaitKey));
+    if (--waitCount == 0) waitLongest = 0;
+}
+
+// Orders live rows by priority, then handle: recurring occurrences first, then one-off bookings
+// by arrival.
+int compareWaitPriority(const void *a, const void *b) {
+    Booking *bookingA = liveBooking(*(const int *)a);
+    Booking *bookingB = liveBooking(*(const int *)b);
+    if (bookingA->priority != bookingB->priority) return bookingA->priority - bookingB->priority;
+    return liveEntry(*(const int *)a)->handle - liveEntry(*(const int *)b)->handle;
+}
+
+// Capacity in freedMask was released on the date over [startSlot, endSlot): admits the waiting
+// bookings that overlap it and need some of it, best priority first, for as long as they fit.
+void promoteWaiting(const char *date, int startSlot, int endSlot, int freedMask) {
+    if (freedMask == 0 || waitCount == 0) return;
+    WaitKey from = {dateToDay(date), startSlot - waitLongest + 1, 0, 0, 0};
+    // The date's occurrences are all live already, so admitting below adds none and the rows stay put.
+    expandLiveDays(from.day, from.day);
+    int candidates[MAX_BOOKINGS + MAX_OCCURRENCES], count = 0;
+    for (int k = waitPosition(&from); k < waitCount; k++) {
+        WaitKey *key = &waitlist[k];
+        if (key->day != from.day || key->startSlot >= endSlot) break;
+        if (key->startSlot + key->slots <= startSlot || !(key->mask & freedMask)) continue;
+        int i = findLiveRow(key->handle);
+        if (i != -1) candidates[count++] = i;
+    }
+    qsort(candidates, count, sizeof(int), compareWaitPriority);
+    for (int c = 0; c < count; c++) {
+        int i = candidates[c];
+        Booking *b = liveBooking(i);
+        if (!admitLive(i)) continue;
+        dequeueWaiting(i);
+        promotedCount++;
+        if (i < OCCURRENCE_ROW) printf("Booking #%d (%s on %s at %s) promoted from the waitlist.\n", liveEntries[i].handle,
+                                       b->memberName, b->date, b->time);
+        else printf("Recurring booking of %s on %s at %s promoted from the waitlist.\n", b->memberName, b->date, b->time);
+    }
+}
+
+// Drops cancelled bookings from the booking tables; run before a pass or when the table is full.
+void compactCancelled() {
+    int kept = 0;
+    for (int i = 0; i < totalBookings; i++) {
+        if (liveEntries[i].status == LIVE_CANCELLED) continue;
+        initialBookings[kept] = initialBookings[i];
+        bookings[kept] = bookings[i];
+        liveEntries[kept] = liveEntries[i];
+        kept++;
+    }
+    totalBookings = kept;
+}
+
+void cancelBooking(int handle) {
+    int i = findBookingByHandle(handle);
+    if (i == -1) {
+        printf("Booking #%d not found.\n", handle);
+        return;
+    }
+    if (liveEntries[i].status == LIVE_WAITING) dequeueWaiting(i);
+    WaitKey key = waitKeyOf(i);
+    int freedMask = releaseLive(i);
+    liveEntries[i].status = LIVE_CANCELLED;
+    printf("Booking #%d (%s on %s at %s) cancelled.\n", handle, initialBookings[i].memberName,
+           initialBookings[i].date, initialBookings[i].time);
+    promoteWaiting(initialBookings[i].date, key.startSlot, key.startSlot + key.slots, freedMask);
+}
+
+// Archives the bookings dated before cutoffDay to archive_<cutoff date>.bin (the export format,
+// one LIVE algorithm holding what the live calendars gave each booking), then drops them from the
+// booking tables and the live calendars, so both only hold the active window. Recurring rules
+// whose last occurrence is before the cutoff are retired too. Returns how many bookings and rules
+// expired, or -1 if the archive could not be written (no booking is dropped then).
+int expireBefore(int cutoffDay) {
+    static BookingRecord records[MAX_BOOKINGS];
+    int expired[MAX_BOOKINGS];
+    int count = 0;
+    char cutoff[11], path[32];
+    dayToDate(cutoffDay, cutoff);
+
+    int rules = 0, retired[MAX_RULES] = {0}, remap[MAX_RULES] = {0};
+    for (int r = 0; r < totalRules; r++) {
+        retired[r] = lastOccurrenceDay(&recurrenceRules[r]) < cutoffDay;
+        remap[r] = r - rules;
+        if (retired[r]) rules++;
+        else recurrenceRules[r - rules] = recurrenceRules[r];
+    }
+    totalRules -= rules;
+    dropOccurrences(retired, remap, cutoffDay);
+    if (rules > 0) printf("Retired %d recurring booking(s) that ended before %s.\n", rules, cutoff);
+
+    for (int i = 0; i < totalBookings; i++) {
+        if (liveEntries[i].status == LIVE_CANCELLED || dateToDay(initialBookings[i].date) >= cutoffDay) continue;
+        Booking b = initialBookings[i];
+        b.passIndex = count;
+        b.accepted = liveEntries[i].status == LIVE_ADMITTED;
+        b.parkingSlot = b.accepted ? liveEntries[i].bay : -1;
+        b.assignedSite = b.accepted ? liveEntries[i].site : 0;
+        records[count] = packBooking(&b);
+        expired[count++] = i;
+    }
+    if (count > 0) {
+        snprintf(path, sizeof(path), "archive_%s.bin", cutoff);
+        const char *algorithms[1] = {"LIVE"};
+        BookingRecord *columns[1] = {records};
+        const char *error = writeExport(path, algorithms, columns, 1, count);
+        if (error != NULL) {
+            printf("%s: %s. Bookings before %s are kept.\n", error, path, cutoff);
+            return -1;
+        }
+
+        for (int e = 0; e < count; e++) {
+            int i = expired[e];
+            if (liveEntries[i].status == LIVE_WAITING) dequeueWaiting(i);
+            releaseLive(i);
+            liveEntries[i].status = LIVE_CANCELLED;
+        }
+        compactCancelled();
+    }
+    // The pages before the cutoff hold nothing now.
+    Calendar *savedCalendar = calendar;
+    int pages = 0;
+    for (int s = 0; s < siteCount; s++) {
+        calendar = &liveCalendars[s];
+        for (int o = 0; o < calendar->dayCount;) {
+            const char *date = calendar->days[calendar->dayOrder[o]].date;
+            if (date[0] == '\0' || dateToDay(date) >= cutoffDay) o++;
+            else {
+                removeDay(o);
+                pages++;
+            }
+        }
+    }
+    useCalendar(savedCalendar);
+    if (count > 0) printf("Archived %d booking(s) dated before %s to %s and freed %d day page(s).\n", count, cutoff, path, pages);
+    else if (pages > 0) printf("Freed %d day page(s) dated before %s.\n", pages, cutoff);
+    return count + rules;
+}
+
+// With a retention set, expires the bookings older than it once per day, before the first
+// booking or pass of that day.
+void expireIfDue() {
+    static int lastExpiryDay = -1;
+    if (retentionDays == 0 || todayDay() == lastExpiryDay) return;
+    if (expireBefore(todayDay() - retentionDays) >= 0) lastExpiryDay = todayDay();
+}
+
+// Moves a booking to a new date, time and duration. If it does not fit there the booking keeps
+// its old time (and whatever it held in the live calendar).
+void modifyBooking(int handle, char *date, char *time, float duration) {
+    int i = findBookingByHandle(handle);
+    if (i == -1) {
+        printf("Booking #%d not found.\n", handle);
+        return;
+    }
+    Booking old = initialBookings[i];
+    int wasAdmitted = liveEntries[i].status == LIVE_ADMITTED;
+    if (!wasAdmitted) dequeueWaiting(i);
+    WaitKey oldKey = waitKeyOf(i);
+    LiveEntry oldEntry = liveEntries[i];
+    beginTransaction();
+    int freedMask = releaseLive(i);
+    strcpy(initialBookings[i].date, date);
+    strcpy(initialBookings[i].time, time);
+    initialBookings[i].duration = duration;
+
+    if (admitLive(i)) {
+        commitTransaction();
+        bookings[i] = initialBookings[i];
+        printf("Booking #%d moved to %s at %s for %.2f hours.\n", handle, date, time, duration);
+        promoteWaiting(old.date, oldKey.startSlot, oldKey.startSlot + oldKey.slots, freedMask);
+    } else {
+        // Undo the release, so the booking keeps its old site and bay as well as its time.
+        rollbackTransaction();
+        initialBookings[i] = old;
+        liveEntries[i] = oldEntry;
+        if (!wasAdmitted) enqueueWaiting(i);
+        printf("Booking #%d cannot be moved to %s at %s: no bay or essentials free. It keeps its old time.\n", handle, date, time);
+    }
+}
+
+// Bitset/packed fast paths. Pages keep per-cell state (the generic representation) plus, per slot,
+// a bitset of occupied bays and the remaining stock packed one byte per resource. Sites with at
+// most FAST_BAYS bays search bays and check stock on those words instead of scanning cells.
+int useBitsets() {
+    return fastPathsEnabled && sites[calendar->site].bays <= FAST_BAYS;
+}
+
+int useStockLanes() {
+    return fastPathsEnabled && MAX_RESOURCES <= 8;
+}
+
+uint64_t packStock(const int values[MAX_RESOURCES]) {
+    uint64_t packed = 0;
+    for (int r = 0; r < MAX_RESOURCES && r < 8; r++) {
+        packed |= (uint64_t)values[r] << (8 * r);
+    }
+    return packed;
+}
+
+// Rebuilds the bitsets of a page from its cells after they were written wholesale.
+void refreshDayMasks(DayCalendar *page) {
+    for (int k = 0; k < timeSlots; k++) {
+        uint64_t busy = 0;
+        for (int j = 0; j < FAST_BAYS; j++) {
+            if (page->parking[k][j] == 0) busy |= (uint64_t)1 << j;
+        }
+        page->busyBays[k] = busy;
+        page->stockLanes[k] = packStock(page->resources[k]);
+    }
+}
+
+// Adds sign * demand to the stock of the current day over [startSlot, endSlot).
+void adjustStock(int startSlot, int endSlot, int demand[MAX_RESOURCES], int sign) {
+    uint64_t packed = packStock(demand);
+    for (int k = startSlot; k < endSlot; k++) {
+        for (int r = 0; r < MAX_RESOURCES; r++) {
+            resourceAvailability[k][r] += sign * demand[r];
+        }
+        calendar->days[currentDay].stockLanes[k] += sign > 0 ? packed : -packed;
+    }
+    calendar->days[currentDay].version++;
+    UndoEntry *entry = transactionDepth > 0 && startSlot < endSlot ? logUndo(&calendar->days[currentDay], UNDO_STOCK) : NULL;
+    if (entry) {
+        entry->demand = packed;
+        entry->startSlot = startSlot;
+        entry->endSlot = endSlot;
+        entry->sign = sign > 0 ? 1 : -1;
+    }
+}
+
+// Appends an entry for a write to page, or returns NULL (and marks the log unusable) when full.
+UndoEntry* logUndo(DayCalendar *page, int kind) {
+    if (undoCount == UNDO_LOG_SIZE) {
+        undoOverflow = 1;
+        return NULL;
+    }
+    UndoEntry *entry = &undoLog[undoCount++];
+    entry->page = page;
+    entry->kind = kind;
+    return entry;
+}
+
+// Transactions nest: commit keeps the writes (an enclosing transaction can still undo them),
+// rollback undoes every write since the matching begin, newest first.
+void beginTransaction() {
+    if (transactionDepth == MAX_TRANSACTION_DEPTH) {
+        printf("Transactions nested too deep.\n");
+        exit(1);
+    }
+    transactionMarks[transactionDepth++] = undoCount;
+}
+
+void commitTransaction() {
+    if (transactionDepth == 0) return;
+    transactionDepth--;
+    if (transactionDepth == 0) {
+        undoCount = 0;
+        undoOverflow = 0;
+    }
+}
+
+// Returns 0 if the log overflowed inside the transaction, leaving its writes in place.
+int rollbackTransaction() {
+    if (transactionDepth == 0) return 1;
+    int mark = transactionMarks[--transactionDepth];
+    if (undoOverflow) {
+        printf("Undo log full: tentative calendar changes could not be rolled back.\n");
+        undoCount = mark;
+        if (transactionDepth == 0) undoOverflow = 0;
+        return 0;
+    }
+    while (undoCount > mark) {
+        UndoEntry *entry = &undoLog[--undoCount];
+        DayCalendar *page = entry->page;
+        if (entry->kind == UNDO_BAY) {
+            uint64_t bit = entry->bay < FAST_BAYS ? (uint64_t)1 << entry->bay : 0;
+            page->parking[entry->startSlot][entry->bay] = entry->value;
+            if (entry->value) page->busyBays[entry->startSlot] &= ~bit;
+            else page->busyBays[entry->startSlot] |= bit;
+        } else {
+            for (int k = entry->startSlot; k < entry->endSlot; k++) {
+                for (int r = 0; r < MAX_RESOURCES; r++) {
+                    page->resources[k][r] -= entry->sign * (int)((entry->demand >> (8 * r)) & 0xFF);
+                }
+                page->stockLanes[k] += entry->sign > 0 ? -entry->demand : entry->demand;
+            }
+        }
+        page->version++;
+    }
+    return 1;
+}
+
+// 1 if the current day has the demanded stock left in every slot of [startSlot, endSlot).
+int stockFits(int startSlot, int endSlot, int demand[MAX_RESOURCES]) {
+    if (useStockLanes()) {
+        // Each byte holds at most MAX_STOCK, so (lane | 0x80) - demand keeps its top bit exactly
+        // when the lane has enough, and never borrows from the next byte.
+        const uint64_t high = 0x8080808080808080ULL;
+        uint64_t packed = packStock(demand);
+        for (int k = startSlot; k < endSlot; k++) {
+            if ((((calendar->days[currentDay].stockLanes[k] | high) - packed) & high) != high) return 0;
+        }
+        return 1;
+    }
+    for (int r = 0; r < MAX_RESOURCES; r++) {
+        if (demand[r] == 0) continue;
+        for (int k = startSlot; k < endSlot; k++) {
+            if (demand[r] > resourceAvailability[k][r]) return 0;
+        }
+    }
+    return 1;
+}
+
+// Bitset of the bays of the current day that are occupied at some slot of [startSlot, endSlot).
+uint64_t busyBaysOver(int startSlot, int endSlot) {
+    uint64_t busy = 0;
+    for (int k = startSlot; k < endSlot; k++) {
+        busy |= calendar->days[currentDay].busyBays[k];
+    }
+    return busy;
+}
+
+// Feasibility of every start slot of a day at once, for the suggestions. Each slot gets a word:
+// the bays free in it (all ones if no bay is needed), or 0 if its packed stock is short of the
+// demand. A start is feasible when the AND of the words over the booking's slots is nonzero, i.e.
+// some bay is free throughout and the stock never runs short. The sliding AND is built by doubling
+// (log2 of the duration passes over the day), with AVX2 or SSE2 when the build targets them.
+const char* feasibilityKernelName() {
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE2__)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+// target[i] &= source[i] for i < count.
+void andWords(uint64_t *target, const uint64_t *source, int count) {
+    int i = 0;
+#if defined(__AVX2__)
+    for (; i + 4 <= count; i += 4) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)&target[i]), b = _mm256_loadu_si256((const __m256i *)&source[i]);
+        _mm256_storeu_si256((__m256i *)&target[i], _mm256_and_si256(a, b));
+    }
+#elif defined(__SSE2__)
+    for (; i + 2 <= count; i += 2) {
+        __m128i a = _mm_loadu_si128((const __m128i *)&target[i]), b = _mm_loadu_si128((const __m128i *)&source[i]);
+        _mm_storeu_si128((__m128i *)&target[i], _mm_and_si128(a, b));
+    }
+#endif
+    for (; i < count; i++) target[i] &= source[i];
+}
+
+// Sets bit s of bitmap (FEASIBLE_WORDS words) for every start slot s of page day where a booking
+// of durationSlots slots fits. Needs the bitsets (useBitsets) when needsBay is set.
+void feasibleStarts(int day, int durationSlots, int needsBay, const int demand[MAX_RESOURCES], uint64_t bitmap[FEASIBLE_WORDS]) {
+    DayCalendar *page = &calendar->days[day];
+    // Slots past the end of the day stay 0, so windows running over it are never feasible.
+    uint64_t power[2 * MAX_TIME_SLOTS] = {0}, result[MAX_TIME_SLOTS];
+    memset(bitmap, 0, FEASIBLE_WORDS * sizeof(uint64_t));
+    for (int r = 0; r < MAX_RESOURCES; r++) {
+        if (demand[r] > MAX_STOCK) return;
+    }
+    if (durationSlots > timeSlots) return;
+    if (durationSlots < 1) durationSlots = 1;
+
+    const uint64_t high = 0x8080808080808080ULL;
+    uint64_t packed = packStock(demand);
+    int bays = sites[calendar->site].bays;
+    uint64_t freeMask = !needsBay ? ~0ULL : bays >= 64 ? ~0ULL : ((uint64_t)1 << bays) - 1;
+    int k = 0;
+#if defined(__AVX2__)
+    __m256i vHigh = _mm256_set1_epi64x(high), vPacked = _mm256_set1_epi64x(packed), vFree = _mm256_set1_epi64x(freeMask);
+    for (; k + 4 <= timeSlots; k += 4) {
+        __m256i lanes = _mm256_loadu_si256((const __m256i *)&page->stockLanes[k]);
+        __m256i busy = needsBay ? _mm256_loadu_si256((const __m256i *)&page->busyBays[k]) : _mm256_setzero_si256();
+        __m256i left = _mm256_and_si256(_mm256_sub_epi64(_mm256_or_si256(lanes, vHigh), vPacked), vHigh);
+        __m256i fits = _mm256_cmpeq_epi64(left, vHigh);
+        _mm256_storeu_si256((__m256i *)&power[k], _mm256_and_si256(fits, _mm256_andnot_si256(busy, vFree)));
+    }
+#elif defined(__SSE2__)
+    __m128i vHigh = _mm_set1_epi64x(high), vPacked = _mm_set1_epi64x(packed), vFree = _mm_set1_epi64x(freeMask);
+    for (; k + 2 <= timeSlots; k += 2) {
+        __m128i lanes = _mm_loadu_si128((const __m128i *)&page->stockLanes[k]);
+        __m128i busy = needsBay ? _mm_loadu_si128((const __m128i *)&page->busyBays[k]) : _mm_setzero_si128();
+        __m128i left = _mm_and_si128(_mm_sub_epi64(_mm_or_si128(lanes, vHigh), vPacked), vHigh);
+        __m128i fits = _mm_cmpeq_epi32(left, vHigh); // no 64-bit compare in SSE2: both halves must match
+        fits = _mm_and_si128(fits, _mm_shuffle_epi32(fits, _MM_SHUFFLE(2, 3, 0, 1)));
+        _mm_storeu_si128((__m128i *)&power[k], _mm_and_si128(fits, _mm_andnot_si128(busy, vFree)));
+    }
+#endif
+    for (; k < timeSlots; k++) {
+        uint64_t fits = (((page->stockLanes[k] | high) - packed) & high) == high ? ~0ULL : 0;
+        power[k] = fits & ~(needsBay ? page->busyBays[k] : 0) & freeMask;
+    }
+
+    // power[k] is the AND over [k, k + span); add the spans of the set bits of durationSlots.
+    for (k = 0; k < timeSlots; k++) result[k] = ~0ULL;
+    int offset = 0, span = 1;
+    for (int remaining = durationSlots; remaining > 0; remaining >>= 1) {
+        if (remaining & 1) {
+            andWords(result, power + offset, timeSlots);
+            offset += span;
+        }
+        if (remaining > 1) {
+            andWords(power, power + span, timeSlots);
+            span *= 2;
+        }
+    }
+    for (k = 0; k < timeSlots; k++) {
+        if (result[k]) bitmap[k / 64] |= (uint64_t)1 << (k % 64);
+    }
+}
+
+// Times findFreeBay and stockFits over the same random queries on a busy synthetic day with the
+// generic and the fast paths, for a few site sizes, and checks both paths give the same answers.
+#define BENCHMARK_QUERIES 200000
+
+void benchmarkCapacity() {
+    static int queryStart[BENCHMARK_QUERIES], queryEnd[BENCHMARK_QUERIES], queryDemand[BENCHMARK_QUERIES][MAX_RESOURCES];
+    int bayCounts[3] = {PARKING_SLOTS, FAST_BAYS, MAX_BAYS};
+    Site savedSite = sites[0];
+    Calendar *savedCalendar = calendar;
+    int savedFastPaths = fastPathsEnabled;
+    useCalendar(&passCalendar);
+    calendar->site = 0;
+
+    printf("Capacity paths, %d queries on a 60%%-busy day, %d-minute slots:\n", BENCHMARK_QUERIES, slotMinutes);
+    printf("    %-8s %-16s %-16s %-10s %-8s\n", "Bays", "Generic ns/op", "Fast ns/op", "Speedup", "Agree");
+    for (int c = 0; c < 3; c++) {
+        srand(2433);
+        sites[0].bays = bayCounts[c];
+        for (int r = 0; r < MAX_RESOURCES; r++) sites[0].stock[r] = MAX_STOCK;
+        resetAvailability();
+        selectDay("2099-01-01");
+        for (int j = 0; j < bayCounts[c]; j++) {
+            for (int k = 0; k < timeSlots; k++) {
+                if (rand() % 10 < 6) setBayRange(k, k + 1, j, 0);
+            }
+        }
+        for (int k = 0; k < timeSlots; k++) {
+            int demand[MAX_RESOURCES];
+            for (int r = 0; r < MAX_RESOURCES; r++) demand[r] = rand() % (MAX_STOCK + 1);
+            adjustStock(k, k + 1, demand, -1);
+        }
+        for (int q = 0; q < BENCHMARK_QUERIES; q++) {
+            queryStart[q] = rand() % timeSlots;
+            queryEnd[q] = queryStart[q] + 1 + rand() % 3;
+            if (queryEnd[q] > timeSlots) queryEnd[q] = timeSlots;
+            for (int r = 0; r < MAX_RESOURCES; r++) queryDemand[q][r] = rand() % 3 == 0 ? 1 + rand() % 2 : 0;
+        }
+
+        double elapsed[2];
+        long checksum[2];
+        for (int mode = 0; mode < 2; mode++) {
+            fastPathsEnabled = mode;
+            checksum[mode] = 0;
+            double started = nowMs();
+            for (int q = 0; q < BENCHMARK_QUERIES; q++) {
+                checksum[mode] += findFreeBay(queryStart[q], queryEnd[q]) * 2 + stockFits(queryStart[q], queryEnd[q], queryDemand[q]);
+            }
+            elapsed[mode] = nowMs() - started;
+        }
+        char fast[16] = "-", speedup[16] = "-";
+        if (bayCounts[c] <= FAST_BAYS) {
+            snprintf(fast, sizeof(fast), "%.1f", elapsed[1] * 1e6 / BENCHMARK_QUERIES);
+            snprintf(speedup, sizeof(speedup), "%.2fx", elapsed[0] / elapsed[1]);
+        }
+        printf("    %-8d %-16.1f %-16s %-10s %-8s\n", bayCounts[c], elapsed[0] * 1e6 / BENCHMARK_QUERIES, fast, speedup,
+               checksum[0] == checksum[1] ? "yes" : "NO");
+    }
+
+    sites[0] = savedSite;
+    fastPathsEnabled = savedFastPaths;
+    resetAvailability();
+    useCalendar(savedCalendar);
+}
+
+// Times the feasibility of every start of a busy synthetic day, per random (duration, bay need,
+// demand) query: the scalar per-start loops over cells, the free-window index, and feasibleStarts.
+// Checks the three agree. Run for 60- and 15-minute slots and a small and a full bitset site.
+#define FEASIBILITY_QUERIES 20000
+
+void benchmarkFeasibility() {
+    static int queryDuration[FEASIBILITY_QUERIES], queryBay[FEASIBILITY_QUERIES], queryDemand[FEASIBILITY_QUERIES][MAX_RESOURCES];
+    int slotChoices[2] = {60, 15}, bayCounts[2] = {PARKING_SLOTS, FAST_BAYS};
+    Site savedSite = sites[0];
+    Calendar *savedCalendar = calendar;
+    int savedSlotMinutes = slotMinutes;
+    useCalendar(&passCalendar);
+    calendar->site = 0;
+
+    printf("Feasibility of every start, %d queries on a 60%%-busy day (%s kernel):\n", FEASIBILITY_QUERIES, feasibilityKernelName());
+    printf("    %-7s %-6s %-14s %-14s %-14s %-9s %-6s\n", "Slots", "Bays", "Scalar ns/op", "Index ns/op", "Kernel ns/op", "Speedup", "Agree");
+    for (int c = 0; c < 4; c++) {
+        srand(2447);
+        slotMinutes = slotChoices[c / 2];
+        timeSlots = MINUTES_PER_DAY / slotMinutes;
+        sites[0].bays = bayCounts[c % 2];
+        for (int r = 0; r < MAX_RESOURCES; r++) sites[0].stock[r] = MAX_STOCK;
+        resetAvailability();
+        int day = selectDay("2099-01-01");
+        for (int j = 0; j < sites[0].bays; j++) {
+            for (int k = 0; k < timeSlots; k++) {
+                if (rand() % 10 < 6) setBayRange(k, k + 1, j, 0);
+            }
+        }
+        for (int k = 0; k < timeSlots; k++) {
+            int demand[MAX_RESOURCES];
+            for (int r = 0; r < MAX_RESOURCES; r++) demand[r] = rand() % (MAX_STOCK + 1);
+            adjustStock(k, k + 1, demand, -1);
+        }
+        for (int q = 0; q < FEASIBILITY_QUERIES; q++) {
+            queryDuration[q] = 1 + rand() % (timeSlots / 8);
+            queryBay[q] = rand() % 4 != 0;
+            for (int r = 0; r < MAX_RESOURCES; r++) queryDemand[q][r] = rand() % 4 == 0 ? 1 + rand() % 2 : 0;
+        }
+
+        double elapsed[3];
+        uint64_t checksum[3] = {0};
+        for (int mode = 0; mode < 3; mode++) {
+            double started = nowMs();
+            for (int q = 0; q < FEASIBILITY_QUERIES; q++) {
+                uint64_t bitmap[FEASIBLE_WORDS] = {0};
+                int duration = queryDuration[q], *demand = queryDemand[q];
+                if (mode == 2) {
+                    feasibleStarts(day, duration, queryBay[q], demand, bitmap);
+                } else {
+                    if (mode == 1) buildFreeWindowIndex(day);
+                    FreeWindowIndex *index = &calendar->freeWindows[day];
+                    for (int s = 0; s + duration <= timeSlots; s++) {
+                        int feasible = 1;
+                        if (mode == 1) {
+                            feasible = !queryBay[q] || index->bayRun[s] >= duration;
+                            for (int r = 0; r < MAX_RESOURCES && feasible; r++) {
+                                if (demand[r] > 0 && index->resourceRun[r][demand[r]][s] < duration) feasible = 0;
+                            }
+                        } else {
+                            for (int r = 0; r < MAX_RESOURCES && feasible; r++) {
+                                for (int k = s; k < s + duration && feasible; k++) feasible = resourceAvailability[k][r] >= demand[r];
+                            }
+                            int bayFree = !queryBay[q];
+                            for (int j = 0; j < sites[0].bays && feasible && !bayFree; j++) {
+                                bayFree = 1;
+                                for (int k = s; k < s + duration && bayFree; k++) bayFree = parkingAvailability[k][j] != 0;
+                            }
+                            feasible = feasible && bayFree;
+                        }
+                        if (feasible) bitmap[s / 64] |= (uint64_t)1 << (s % 64);
+                    }
+                }
+                for (int w = 0; w < FEASIBLE_WORDS; w++) checksum[mode] = checksum[mode] * 31 + bitmap[w];
+            }
+            elapsed[mode] = nowMs() - started;
+        }
+        printf("    %-7d %-6d %-14.1f %-14.1f %-14.1f %-9.2f %-6s\n", timeSlots, sites[0].bays,
+               elapsed[0] * 1e6 / FEASIBILITY_QUERIES, elapsed[1] * 1e6 / FEASIBILITY_QUERIES, elapsed[2] * 1e6 / FEASIBILITY_QUERIES,
+               elapsed[0] / elapsed[2], checksum[0] == checksum[1] && checksum[1] == checksum[2] ? "yes" : "NO");
+    }
+
+    sites[0] = savedSite;
+    slotMinutes = savedSlotMinutes;
+    timeSlots = MINUTES_PER_DAY / slotMinutes;
+    resetAvailability();
+    useCalendar(savedCalendar);
+}
+
+// Days since 1970-01-01 of today, on the same scale as dateToDay.
+int todayDay() {
+    return (int)(time(NULL) / 86400);
+}
+
+// Applies the capacities in a config file. One setting per line, '#' starts a comment:
+//   slotMinutes 15|20|30|60     bays 12          stock 2          stock battery 3
+//   site north 6 2              maxBookings 80   horizon 60       fastPaths on|off
+//   retention 7
+//   essential charger adapter   (an essential and the essentials it needs)
+// "bays" and "stock" set the main site, "site" adds one like addSite. Returns 0 if the file
+// cannot be opened.
+int loadConfig(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) return 0;
+    char line[128];
+    int lineNum = 0;
+    while (fgets(line, sizeof(line), file)) {
+        lineNum++;
+        line[strcspn(line, "#\n")] = 0;
+        char key[20] = "", word[20] = "";
+        int value = 0;
+        int fields = sscanf(line, "%19s %19s %d", key, word, &value);
+        if (fields < 1) continue;
+        const char *error = NULL;
+
+        if (strcmp(key, "slotMinutes") == 0) {
+            value = atoi(word);
+            if (value != 15 && value != 20 && value != 30 && value != 60) error = "slotMinutes must be 15, 20, 30 or 60";
+            else {
+                slotMinutes = value;
+                timeSlots = MINUTES_PER_DAY / slotMinutes;
+            }
+        } else if (strcmp(key, "bays") == 0) {
+            value = atoi(word);
+            if (value < 0 || value > MAX_BAYS) error = "Invalid bay count";
+            else sites[0].bays = value;
+        } else if (strcmp(key, "stock") == 0) {
+            int r = fields == 3 ? getResourceIndex(word) : -1;
+            if (fields == 2) value = atoi(word);
+            if (fields == 3 && r == -1) error = "Invalid resource";
+            else if (value < 0 || value > MAX_STOCK) error = "Invalid stock";
+            for (int i = 0; i < essentialCount && error == NULL; i++) {
+                if (r == -1 || r == i) sites[0].stock[i] = value;
+            }
+        } else if (strcmp(key, "site") == 0) {
+            char command[160];
+            const char *rest = strstr(line, "site") + 4;
+            snprintf(command, sizeof(command), "addSite -%s", rest + strspn(rest, " \t"));
+            error = addSite(command);
+        } else if (strcmp(key, "maxBookings") == 0) {
+            value = atoi(word);
+            if (value < 1 || value > MAX_BOOKINGS) error = "maxBookings must be between 1 and 100";
+            else maxBookings = value;
+        } else if (strcmp(key, "horizon") == 0) {
+            value = atoi(word);
+            if (value < 0) error = "Invalid horizon";
+            else horizonDays = value;
+        } else if (strcmp(key, "retention") == 0) {
+            value = atoi(word);
+            if (value < 0) error = "Invalid retention";
+            else retentionDays = value;
+        } else if (strcmp(key, "essential") == 0) {
+            error = addEssential(strstr(line, "essential") + 9);
+        } else if (strcmp(key, "fastPaths") == 0) {
+            fastPathsEnabled = strcmp(word, "off") != 0;
+        } else {
+            error = "Unknown setting";
+        }
+        if (error != NULL) printf("Error in config file %s at line %d: %s\n", path, lineNum, error);
+    }
+    fclose(file);
+    const char *error = closeBundles();
+    if (error != NULL) printf("Error in config file %s: %s\n", path, error);
+
+    // Pages are laid out for the capacities, so start the calendars over.
+    for (int s = 0; s < siteCount; s++) {
+        liveCalendars[s].site = s;
+        useCalendar(&liveCalendars[s]);
+        resetAvailability();
+    }
+    useCalendar(&passCalendar);
+    resetAvailability();
+    return 1;
+}
+
+// Adds an essential from "<name> [<needed> ...]": the essentials that must be taken with it.
+// Needs are resolved, and closed transitively, by closeBundles once the table is complete.
+const char* addEssential(const char *spec) {
+    char name[20] = "";
+    int length = 0;
+    if (sscanf(spec, "%19s%n", name, &length) != 1) return "Usage: essential <name> [<needed essential> ...]";
+    int r = getResourceIndex(name);
+    if (r == -1) {
+        if (essentialCount == MAX_RESOURCES) return "Essential limit reached";
+        r = essentialCount++;
+        strcpy(resourceNames[r], name);
+        for (int s = 0; s < MAX_SITES; s++) sites[s].stock[r] = RESOURCE_STOCK;
+    }
+    snprintf(essentialNeeds[r], sizeof(essentialNeeds[r]), "%s", spec + length);
+    return NULL;
+}
+
+// Resolves the needs of every essential into bundleMask, the set of essentials one request of it
+// takes, following needs of needs. Unknown needs are skipped and the last one is returned as an error.
+const char* closeBundles() {
+    static char error[96];
+    const char *result = NULL;
+    for (int r = 0; r < essentialCount; r++) {
+        bundleMask[r] = 1 << r;
+        char needed[20];
+        int offset = 0, length;
+        while (sscanf(essentialNeeds[r] + offset, "%19s%n", needed, &length) == 1) {
+            offset += length;
+            int n = getResourceIndex(needed);
+            if (n == -1) {
+                snprintf(error, sizeof(error), "Unknown essential needed by %.19s: %.19s", resourceNames[r], needed);
+                result = error;
+                continue;
+            }
+            bundleMask[r] |= 1 << n;
+        }
+    }
+    for (int k = 0; k < essentialCount; k++) {
+        for (int r = 0; r < essentialCount; r++) {
+            if (bundleMask[r] & (1 << k)) bundleMask[r] |= bundleMask[k];
+        }
+    }
+    return result;
+}
+
+void loadDefaultEssentials() {
+    for (unsigned i = 0; i < sizeof(defaultEssentials) / sizeof(defaultEssentials[0]); i++) {
+        addEssential(defaultEssentials[i]);
+    }
+    closeBundles();
+}
+
+// Days since 1970-01-01 of a YYYY-MM-DD date (proleptic Gregorian calendar).
+int dateToDay(const char *date) {
+    int year, month, day;
+    if (sscanf(date, "%4d-%2d-%2d", &year, &month, &day) != 3) return -1;
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+void dayToDate(int dayNumber, char *date) {
+    int z = dayNumber + 719468;
+    int era = (z >= 0 ? z : z - 146096) / 146097;
+    int dayOfEra = z - era * 146097;
+    int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int mp = (5 * dayOfYear + 2) / 153;
+    int day = dayOfYear - (153 * mp + 2) / 5 + 1;
+    int month = mp < 10 ? mp + 3 : mp - 9;
+    int year = yearOfEra + era * 400 + (month <= 2);
+    sprintf(date, "%04d-%02d-%02d", year, month, day);
+}
+
+// 0 = Sunday ... 6 = Saturday (1970-01-01 was a Thursday).
+int dayOfWeek(int dayNumber) {
+    return ((dayNumber % 7) + 11) % 7;
+}
+
+int getBookingPriority(const char *type) {
+    if (strcmp(type, "event") == 0) return PRIORITY_EVENT;
+    if (strcmp(type, "reservation") == 0) return PRIORITY_RESERVATION;
+    if (strcmp(type, "parking") == 0) return PRIORITY_PARKING;
+    if (strcmp(type, "essentials") == 0) return PRIORITY_ESSENTIAL;
+    return -1;
+}
+
+// Parses "addRecurring -member date time duration daily|weekdays|weekly until|count type [essentials...]"
+// and stores it as one rule. Returns NULL on success or the reason the command was refused.
+const char* addRecurrence(const char *command) {
+    char memberName[20] = "", date[11] = "", time[6] = "", frequency[10] = "", end[11] = "", type[12] = "";
+    char essentials[MAX_RESOURCES][20];
+    float duration = 0;
+    memset(essentials, 0, sizeof(essentials));
+    int fields = sscanf(command, "addRecurring -%19s %10s %5s %f %9s %10s %11s %19s %19s %19s %19s %19s %19s",
+                        memberName, date, time, &duration, frequency, end, type, essentials[0], essentials[1],
+                        essentials[2], essentials[3], essentials[4], essentials[5]);
+    if (fields < 7) return "Usage: addRecurring -member YYYY-MM-DD hh:mm n.n daily|weekdays|weekly <end date|count> <type> [essentials]";
+    if (!isValidMember(memberName)) return "Invalid member name";
+    if (!isValidDate(date)) return "Invalid start date (Expected: YYYY-MM-DD)";
+    if (!isValidTime(time, duration)) return "Invalid time (Expected: HH:MM) or invalid duration";
+    for (int i = 0; i < MAX_RESOURCES; i++) {
+        if (strlen(essentials[i]) > 0 && !isValidResource(essentials[i])) return "Invalid resource";
+    }
+    if (totalRules >= MAX_RULES) return "Recurring booking limit reached";
+
+    RecurrenceRule *rule = &recurrenceRules[totalRules];
+    if (strcmp(frequency, "daily") == 0) rule->frequency = RECUR_DAILY;
+    else if (strcmp(frequency, "weekdays") == 0) rule->frequency = RECUR_WEEKDAYS;
+    else if (strcmp(frequency, "weekly") == 0) rule->frequency = RECUR_WEEKLY;
+    else return "Invalid frequency (Expected: daily, weekdays or weekly)";
+    rule->priority = getBookingPriority(type);
+    if (rule->priority == -1) return "Invalid type (Expected: parking, reservation, event or essentials)";
+
+    rule->firstDay = dateToDay(date);
+    if (strchr(end, '-') != NULL) {
+        if (!isValidDate(end) || dateToDay(end) < rule->firstDay) return "Invalid end date";
+        rule->lastDay = dateToDay(end);
+        rule->count = 0;
+    } else {
+        long count = strtol(end, NULL, 10); // range-checked before lastDay is worked out from it
+        if (count <= 0 || count > MAX_RULE_COUNT) return "Invalid occurrence count (Expected: 1 to 36500)";
+        rule->count = count;
+        rule->lastDay = rule->firstDay + rule->count * 7; // generous bound, count stops it first
+    }
+    strcpy(rule->memberName, memberName);
+    strcpy(rule->time, time);
+    rule->duration = duration;
+    memcpy(rule->essentials, essentials, sizeof(essentials));
+    computeResourceDemand(rule->essentials, rule->demand);
+    rule->site = requestedSite;
+    totalRules++;
+    printf("Recurring booking added: %s %s %s from %s at %s for %.2f hours.\n", memberName, frequency, type, date, time, duration);
+    return NULL;
+}
+
+// Occurrence number of the rule on the given day, or -1 if the rule does not fall on it.
+int recurrenceOccurrence(RecurrenceRule *rule, int dayNumber) {
+    if (dayNumber < rule->firstDay || dayNumber > rule->lastDay) return -1;
+    int offset = dayNumber - rule->firstDay;
+    int occurrence;
+    if (rule->frequency == RECUR_DAILY) {
+        occurrence = offset;
+    } else if (rule->frequency == RECUR_WEEKLY) {
+        if (offset % 7 != 0) return -1;
+        occurrence = offset / 7;
+    } else {
+        int weekday = dayOfWeek(dayNumber);
+        if (weekday == 0 || weekday == 6) return -1;
+        occurrence = offset / 7 * 5;
+        for (int d = rule->firstDay + offset / 7 * 7; d < dayNumber; d++) {
+            if (dayOfWeek(d) != 0 && dayOfWeek(d) != 6) occurrence++;
+        }
+    }
+    if (rule->count > 0 && occurrence >= rule->count) return -1;
+    return occurrence;
+}
+
+// Day of the rule's last occurrence.
+int lastOccurrenceDay(RecurrenceRule *rule) {
+    int day = rule->lastDay;
+    while (day > rule->firstDay && recurrenceOccurrence(rule, day) < 0) day--;
+    return day;
+}
+
+// Appends the occurrences of every rule that fall on the given day to the current pass. They
+// take the MAX_OCCURRENCES rows after the one-off bookings, so only the occurrences inside the
+// days a pass touches count. Returns 0 if they would not fit; the pass is then not scheduled.
+int expandRecurrencesOn(int dayNumber) {
+    char date[11];
+    dayToDate(dayNumber, date);
+    for (int r = 0; r < totalRules; r++) {
+        RecurrenceRule *rule = &recurrenceRules[r];
+        if (recurrenceOccurrence(rule, dayNumber) < 0) continue;
+        if (horizonDays > 0 && dayNumber > todayDay() + horizonDays) continue;
+        if (totalBookings >= passBaseBookings + MAX_OCCURRENCES) {
+            printf("Too many recurring occurrences from %s on (Maximum: %d per pass). The pass is not scheduled; give a shorter date window.\n", date, MAX_OCCURRENCES);
+            return 0;
+        }
+        occurrenceBooking(rule, date, &bookings[totalBookings]);
+        initialBookings[totalBookings] = bookings[totalBookings];
+        totalBookings++;
+    }
+    return 1;
+}
+
+// The booking a rule makes on the given date.
+void occurrenceBooking(RecurrenceRule *rule, const char *date, Booking *b) {
+    memset(b, 0, sizeof(Booking));
+    strcpy(b->memberName, rule->memberName);
+    strcpy(b->date, date);
+    strcpy(b->time, rule->time);
+    b->duration = rule->duration;
+    memcpy(b->essentials, rule->essentials, sizeof(b->essentials));
+    memcpy(b->demand, rule->demand, sizeof(b->demand));
+    b->priority = rule->priority;
+    b->parkingSlot = -1;
+    b->site = rule->site;
+}
+
+// Prepares the bookings of one printBookings pass: the one-off bookings plus the occurrences of
+// recurring rules on the days the pass touches. Those are the days of the one-off bookings and,
+// if args holds "YYYY-MM-DD [YYYY-MM-DD]", every day of that window. Returns 0 if there is nothing to do.
+int beginPass(const char *args) {
+    char first[20] = "", from[20] = "", to[20] = "";
+    expireIfDue();
+    compactCancelled();
+    passBaseBookings = totalBookings;
+    sscanf(args, "%19s", first);
+    if (first[0] == '-') args = strstr(args, first) + strlen(first); // printBookings -<anything> falls back here
+    int fields = sscanf(args, "%19s %19s", from, to);
+    if (fields >= 1 && (!isValidDate(from) || (fields == 2 && !isValidDate(to)))) {
+        printf("Invalid date window (Expected: YYYY-MM-DD [YYYY-MM-DD])\n");
+        return 0;
+    }
+
+    if (totalRules > 0) {
+        int touched[MAX_BOOKINGS];
+        int touchedCount = 0;
+        for (int i = 0; i < passBaseBookings; i++) {
+            int day = dateToDay(bookings[i].date);
+            int seen = 0;
+            for (int t = 0; t < touchedCount && !seen; t++) {
+                seen = touched[t] == day;
+            }
+            if (!seen) touched[touchedCount++] = day;
+        }
+        int windowStart = fields >= 1 ? dateToDay(from) : 0;
+        int windowEnd = fields == 2 ? dateToDay(to) : windowStart;
+        int expanded = 1;
+        for (int t = 0; t < touchedCount && expanded; t++) {
+            if (fields < 1 || touched[t] < windowStart || touched[t] > windowEnd) expanded = expandRecurrencesOn(touched[t]);
+        }
+        for (int day = windowStart; fields >= 1 && day <= windowEnd && expanded; day++) {
+            expanded = expandRecurrencesOn(day);
+        }
+        if (!expanded) {
+            endPass();
+            return 0;
+        }
+    }
+
+    if (totalBookings == 0) {
+        printf("No booking(s) have been made.\n");
+        return 0;
+    }
+    routeBookings();
+    return 1;
+}
+
+// Drops the expanded occurrences and any scheduling state the children sent back.
+void endPass() {
+    for (int a = 0; a < 3; a++) passUsage[a].recorded = 0;
+    totalBookings = passBaseBookings;
+    memcpy(bookings, initialBookings, sizeof(bookings));
+}
+
+// Runs one scheduler for every site (see scheduleSites) and prints the combined schedule.
+void runScheduler(void (*scheduler)(), const char *algorithm) {
+    float fragmentation[MAX_SITES];
+    memcpy(bookings, initialBookings, sizeof(bookings)); // not what the previous algorithm left
+    scheduleSites(scheduler, fragmentation);
+    if (usageIndex(scheduler) != -1) recordUsage(&passUsage[usageIndex(scheduler)], fragmentation);
+    double reportStart = nowMs();
+    printBookings(algorithm);
+    if (traceEnabled) {
+        fflush(stdout);
+        fprintf(stderr, "[trace] %s: schedule %.3f ms (longest compute %.3f, process overhead %.3f), report formatting %.3f ms\n",
+                algorithm, lastScheduleMs, lastComputeMs, lastScheduleMs - lastComputeMs, nowMs() - reportStart);
+    }
+}
+
+void addBooking(char *memberName, char *date, char *time, float duration, char essentials[MAX_RESOURCES][20], int priority, int isEssentialBooking) {
+    PHASE_BEGIN(PHASE_INGEST);
+    expireIfDue();
+    if (totalBookings >= maxBookings) compactCancelled();
+    if (horizonDays > 0 && dateToDay(date) > todayDay() + horizonDays) {
+        printf("Booking date %s is beyond the %d-day booking horizon.\n", date, horizonDays);
+    }
+    else if (retentionDays > 0 && dateToDay(date) < todayDay() - retentionDays) {
+        printf("Booking date %s is older than the %d-day retention window.\n", date, retentionDays);
+    }
+    else if (totalBookings >= maxBookings) {
+        printf("Booking limit reached (Maximum: %i). Cannot create more bookings.\n", maxBookings);
+    } 
+    else {
+        Booking *b = &bookings[totalBookings];
+        strcpy(b->memberName, memberName);
+        strcpy(b->date, date);
+        strcpy(b->time, time);
+        b->duration = duration;
+        b->priority = priority;
+        b->parkingSlot = -1;
+        b->accepted = 0;
+        b->reason = REASON_NONE;
+        b->suggestPending = 0;
+        b->site = requestedSite;
+        b->assignedSite = 0;
+        
+        int i;
+        for (i = 0; i < MAX_RESOURCES; i++) {
+            strcpy(b->essentials[i], essentials[i]);
+        }
+        
+        computeResourceDemand(b->essentials, b->demand);
+        totalBookings++;
+        initialBookings[totalBookings - 1] = *b;
+        liveEntries[totalBookings - 1].handle = nextHandle++;
+        if (!admitLive(totalBookings - 1)) {
+            enqueueWaiting(totalBookings - 1);
+            waitlistedCount++;
+        }
+        printf("Booking added: %s on %s at %s for %.2f hours. ", memberName, date, time, duration);
+        // The listed essentials, then (except for essentials bookings) the ones their bundles add.
+        int listed = 0, printed = 0;
+        printf("(");
+        for (i = 0; i < MAX_RESOURCES; i++) {
+            int r = getResourceIndex(b->essentials[i]);
+            if (r == -1) continue;
+            printf(printed++ ? ", %s" : "%s", resourceNames[r]);
+            listed |= 1 << r;
+        }
+        for (int r = 0; r < essentialCount && !isEssentialBooking; r++) {
+            if (b->demand[r] && !(listed & (1 << r))) printf(printed++ ? ", %s" : "%s", resourceNames[r]);
+        }
+        LiveEntry *entry = &liveEntries[totalBookings - 1];
+        if (siteCount > 1 && entry->status == LIVE_ADMITTED) printf(") [handle #%d, %s]\n", entry->handle, sites[entry->site].name);
+        else printf(") [handle #%d]\n", entry->handle);
+    }
+    PHASE_END(PHASE_INGEST);
+}
+
+void processBookings_FCFS() {
+    resetPreemptionStats();
+    setArrivalOrder();
+    for (int i = 0; i < totalBookings; i++) {
+        bookings[i].accepted = 0;
+        bookings[i].parkingSlot = -1;
+    }
+    for (schedulingIndex = 0; schedulingIndex < totalBookings; schedulingIndex++) {
+        scheduleBooking(&bookings[passOrder[schedulingIndex]]);
+    }
+}
+
+void processBookings_Priority() {
+    resetPreemptionStats();
+    sortByPriority();
+    for (int i = 0; i < totalBookings; i++) {
+        bookings[i].accepted = 0;
+        bookings[i].parkingSlot = -1;
+    }
+    for (schedulingIndex = 0; schedulingIndex < totalBookings; schedulingIndex++) {
+        scheduleBooking(&bookings[passOrder[schedulingIndex]]);
+    }
+}
+
+void setArrivalOrder() {
+    for (int i = 0; i < totalBookings; i++) passOrder[i] = i;
+}
+
+void resetPreemptionStats() {
+    evictionCount = 0;
+    replacedCount = 0;
+    droppedCount = 0;
+}
+
+// Lowest-index bay of the current day that is free over [startSlot, endSlot), or -1.
+int findFreeBay(int startSlot, int endSlot) {
+    COUNT(baySearches);
+    if (useBitsets()) {
+        COUNT_ADD(bayProbes, endSlot - startSlot);
+        uint64_t freeBays = ~busyBaysOver(startSlot, endSlot);
+        return freeBays ? __builtin_ctzll(freeBays) : -1;
+    }
+    for (int j = 0; j < sites[calendar->site].bays; j++) {
+        int available = 1;
+        for (int k = startSlot; k < endSlot; k++) {
+            COUNT(bayProbes);
+            if (parkingAvailability[k][j] == 0) {
+                available = 0;
+                break;
+            }
+        }
+        if (available) return j;
+    }
+    return -1;
+}
+
+// Picks a bay of the current day that is free over [startSlot, endSlot) using bayPolicy, or -1.
+int chooseBay(Booking *b, int startSlot, int endSlot) {
+    if (bayPolicy == BAY_FIRST_FIT) return findFreeBay(startSlot, endSlot);
+
+    // Best-fit treats every leftover hour as waste; look-ahead only leftovers no pending booking could use.
+    int shortestPending = timeSlots + 1;
+    if (bayPolicy == BAY_LOOKAHEAD) {
+        for (int i = schedulingIndex + 1; i < totalBookings; i++) {
+            Booking *p = &bookings[passOrder[i]];
+            if (p == b || p->priority == PRIORITY_ESSENTIAL || strcmp(p->date, b->date) != 0) continue;
+            int pStart = timeToMinutes(p->time);
+            int slots = slotEnd(pStart, durationToMinutes(p->duration)) - pStart / slotMinutes;
+            if (slots < shortestPending) shortestPending = slots;
+        }
+    }
+
+    int bestBay = -1, bestWaste = 0, bestGap = 0;
+    int bitsets = useBitsets();
+    uint64_t freeBays = bitsets ? ~busyBaysOver(startSlot, endSlot) : 0;
+    COUNT(baySearches);
+    if (bitsets) COUNT_ADD(bayProbes, endSlot - startSlot);
+    for (int j = 0; j < sites[calendar->site].bays; j++) {
+        int available = 1;
+        if (bitsets) available = (freeBays >> j) & 1;
+        for (int k = startSlot; k < endSlot && available && !bitsets; k++) {
+            COUNT(bayProbes);
+            if (parkingAvailability[k][j] == 0) available = 0;
+        }
+        if (!available) continue;
+        int left = 0, right = 0;
+        while (startSlot - left - 1 >= 0 && parkingAvailability[startSlot - left - 1][j] != 0) left++;
+        while (endSlot + right < timeSlots && parkingAvailability[endSlot + right][j] != 0) right++;
+        int waste = (left < shortestPending ? left : 0) + (right < shortestPending ? right : 0);
+        if (bestBay == -1 || waste < bestWaste || (waste == bestWaste && left + right < bestGap)) {
+            bestBay = j;
+            bestWaste = waste;
+            bestGap = left + right;
+        }
+    }
+    return bestBay;
+}
+
+// Share of free bay-hours that lie outside each bay's largest free gap, over all booked days.
+float bayFragmentation() {
+    int totalFree = 0, largestFree = 0;
+    for (int d = 0; d < calendar->dayCount; d++) {
+        if (calendar->days[d].date[0] == '\0') continue;
+        for (int j = 0; j < sites[calendar->site].bays; j++) {
+            int run = 0, largest = 0;
+            for (int k = 0; k < timeSlots; k++) {
+                if (calendar->days[d].parking[k][j] != 0) {
+                    run++;
+                    totalFree++;
+                    if (run > largest) largest = run;
+                } else {
+                    run = 0;
+                }
+            }
+            largestFree += largest;
+        }
+    }
+    return totalFree > 0 ? (1 - (float)largestFree / totalFree) * 100 : 0;
+}
+
+const char* getBayPolicyName(int policy) {
+    switch (policy) {
+        case BAY_FIRST_FIT: return "first-fit";
+        case BAY_BEST_FIT: return "best-fit";
+        case BAY_LOOKAHEAD: return "look-ahead";
+        default: return "Unknown";
+    }
+}
+
+// Places one booking at its requested time, displacing lower priority bookings if no bay is free.
+void scheduleBooking(Booking *b) {
+    selectDay(b->date);
+    int startMinutes = timeToMinutes(b->time);
+    int durationMinutes = durationToMinutes(b->duration);
+    int startSlot = startMinutes / slotMinutes;
+    int endSlot = slotEnd(startMinutes, durationMinutes);
+
+    int slotFound = -1;
+    if (b->priority != PRIORITY_ESSENTIAL) {
+        slotFound = chooseBay(b, startSlot, endSlot);
+    }
+
+    int resourcesAllocated = allocateResources(startMinutes, durationMinutes, b->demand);
+
+    if (b->priority == PRIORITY_ESSENTIAL) {
+        if (resourcesAllocated) {
+            b->accepted = 1;
+        } else {
+            b->accepted = 0;
+            b->reason = REASON_ESSENTIALS;
+            b->suggestPending = 1;
+        }
+    } else {
+        if (slotFound != -1 && resourcesAllocated) {
+            setBayRange(startSlot, endSlot, slotFound, 0);
+            b->parkingSlot = slotFound;
+            b->accepted = 1;
+        } else if (slotFound == -1) {
+            if (preemptionMode == PREEMPT_LEGACY) {
+                slotFound = displaceFirstOverlap(b, startMinutes, durationMinutes);
+                if (slotFound != -1 && (resourcesAllocated || (resourcesAllocated = allocateResources(startMinutes, durationMinutes, b->demand)))) {
+                    setBayRange(startSlot, endSlot, slotFound, 0);
+                    b->parkingSlot = slotFound;
+                    b->accepted = 1;
+                }
+            } else {
+                slotFound = preemptBay(b, startMinutes, durationMinutes, resourcesAllocated, 0);
+                if (slotFound != -1) resourcesAllocated = 1;
+            }
+            if (!b->accepted) {
+                if (resourcesAllocated) releaseResources(startMinutes, durationMinutes, b->demand);
+                b->reason = resourcesAllocated ? REASON_NO_BAY : REASON_ESSENTIALS;
+                b->suggestPending = 1;
+            }
+        } else {
+            b->accepted = 0;
+            b->reason = REASON_ESSENTIALS;
+            b->suggestPending = 1;
+        }
+    }
+}
+
+// The original displacement rule: evict the first overlapping lower priority booking found on
+// the same date and drop it for good. Kept as PREEMPT_LEGACY for comparison.
+int displaceFirstOverlap(Booking *b, int startMinutes, int durationMinutes) {
+    for (int j = 0; j < totalBookings; j++) {
+        Booking *other = &bookings[passOrder[j]];
+        if (other != b && other->accepted && other->priority > b->priority &&
+            strcmp(other->date, b->date) == 0) {
+            int otherStart = timeToMinutes(other->time);
+            int otherDuration = durationToMinutes(other->duration);
+            int otherEnd = otherStart + otherDuration;
+            if (startMinutes < otherEnd && otherStart < (startMinutes + durationMinutes)) {
+                releaseResources(otherStart, otherDuration, other->demand);
+                if (other->parkingSlot >= 0) {
+                    setBayRange(otherStart / slotMinutes, slotEnd(otherStart, otherDuration), other->parkingSlot, 1);
+                }
+                other->accepted = 0;
+                other->reason = REASON_DISPLACED;
+                evictionCount++;
+                droppedCount++;
+                COUNT(displacements);
+                return other->parkingSlot;
+            }
+        }
+    }
+    return -1;
+}
+
+// Cost of evicting a booking: its priority weight times the hours it holds.
+int disruptionCost(Booking *b) {
+    int startMinutes = timeToMinutes(b->time);
+    return (PRIORITY_ESSENTIAL + 1 - b->priority) * (slotEnd(startMinutes, durationToMinutes(b->duration)) - startMinutes / slotMinutes);
+}
+
+// Frees a bay for b by evicting the lower priority bookings on the bay whose overlapping
+// bookings carry the least disruption cost, then tries to re-place every victim. Returns the
+// bay b now holds (its essentials allocated), or -1 with the calendar unchanged.
+int preemptBay(Booking *b, int startMinutes, int durationMinutes, int resourcesAllocated, int depth) {
+    int startSlot = startMinutes / slotMinutes;
+    int endSlot = slotEnd(startMinutes, durationMinutes);
+    int bestBay = -1, bestCost = 0;
+
+    for (int j = 0; j < sites[calendar->site].bays; j++) {
+        int cost = 0, viable = 1;
+        for (int i = 0; i < totalBookings && viable; i++) {
+            Booking *other = &bookings[i];
+            if (other == b || !other->accepted || other->parkingSlot != j || strcmp(other->date, b->date) != 0) continue;
+            int otherStart = timeToMinutes(other->time);
+            if (otherStart / slotMinutes >= endSlot || slotEnd(otherStart, durationToMinutes(other->duration)) <= startSlot) continue;
+            if (other->priority <= b->priority) viable = 0;
+            else cost += disruptionCost(other);
+        }
+        if (viable && (bestBay == -1 || cost < bestCost)) {
+            bestBay = j;
+            bestCost = cost;
+        }
+    }
+    if (bestBay == -1) return -1;
+
+    int victims[MAX_PASS_BOOKINGS];
+    int victimCount = 0;
+    beginTransaction();
+    for (int i = 0; i < totalBookings; i++) {
+        Booking *other = &bookings[passOrder[i]];
+        if (other == b || !other->accepted || other->parkingSlot != bestBay || strcmp(other->date, b->date) != 0) continue;
+        int otherStart = timeToMinutes(other->time);
+        int otherDuration = durationToMinutes(other->duration);
+        if (otherStart / slotMinutes >= endSlot || slotEnd(otherStart, otherDuration) <= startSlot) continue;
+        releaseResources(otherStart, otherDuration, other->demand);
+        setBayRange(otherStart / slotMinutes, slotEnd(otherStart, otherDuration), bestBay, 1);
+        other->accepted = 0;
+        victims[victimCount++] = passOrder[i];
+    }
+
+    if (!resourcesAllocated && !allocateResources(startMinutes, durationMinutes, b->demand)) {
+        // Evicting would not help; put every victim back where it was.
+        rollbackTransaction();
+        for (int v = 0; v < victimCount; v++) bookings[victims[v]].accepted = 1;
+        return -1;
+    }
+
+    setBayRange(startSlot, endSlot, bestBay, 0);
+    commitTransaction();
+    b->parkingSlot = bestBay;
+    b->accepted = 1;
+    evictionCount += victimCount;
+    COUNT_ADD(displacements, victimCount);
+
+    for (int v = 0; v < victimCount; v++) {
+        Booking *other = &bookings[victims[v]];
+        if (!replaceVictim(other, depth + 1)) {
+            other->parkingSlot = -1;
+            other->reason = REASON_DISPLACED;
+            droppedCount++;
+            other->suggestPending = 1;
+        }
+    }
+    return bestBay;
+}
+
+// Re-admits an evicted booking on another bay at the same time, else at the nearest feasible
+// start within PREEMPT_MAX_SHIFT hours, else by displacing even lower priority bookings while
+// the cascade is shallower than PREEMPT_MAX_DEPTH.
+int replaceVictim(Booking *v, int depth) {
+    int startMinutes = timeToMinutes(v->time);
+    int durationMinutes = durationToMinutes(v->duration);
+    int startSlot = startMinutes / slotMinutes;
+    int endSlot = slotEnd(startMinutes, durationMinutes);
+
+    int bay = chooseBay(v, startSlot, endSlot);
+    if (bay != -1 && allocateResources(startMinutes, durationMinutes, v->demand)) {
+        setBayRange(startSlot, endSlot, bay, 0);
+        v->parkingSlot = bay;
+        v->accepted = 1;
+        replacedCount++;
+        return 1;
+    }
+
+    int starts[MAX_TIME_SLOTS];
+    int maxShift = PREEMPT_MAX_SHIFT * 60 / slotMinutes;
+    COUNT(preemptionSearches);
+    int found = findNearestStarts(currentDay, endSlot - startSlot, 1, v->demand, startSlot, 2 * maxShift, starts, 0);
+    for (int i = 0; i < found; i++) {
+        if (abs(starts[i] - startSlot) > maxShift) break;
+        int newStart = starts[i] * slotMinutes + startMinutes % slotMinutes;
+        int newEnd = slotEnd(newStart, durationMinutes);
+        bay = chooseBay(v, starts[i], newEnd);
+        if (bay != -1 && allocateResources(newStart, durationMinutes, v->demand)) {
+            setBayRange(starts[i], newEnd, bay, 0);
+            snprintf(v->time, sizeof(v->time), "%02u:%02u", (unsigned)newStart / 60 % 24, (unsigned)newStart % 60);
+            v->parkingSlot = bay;
+            v->accepted = 1;
+            v->reason = REASON_MOVED;
+            replacedCount++;
+            return 1;
+        }
+    }
+
+    if (depth < PREEMPT_MAX_DEPTH && preemptBay(v, startMinutes, durationMinutes, 0, depth) != -1) {
+        replacedCount++;
+        return 1;
+    }
+    return 0;
+}
+
+int bookingWeight(int priority) {
+    return optiPriorityWeighted ? (PRIORITY_ESSENTIAL + 1 - priority) : 1;
+}
+
+int compareOptiItems(const void *a, const void *b) {
+    const OptiItem *itemA = (const OptiItem *)a;
+    const OptiItem *itemB = (const OptiItem *)b;
+    if (itemA->endSlot != itemB->endSlot) return itemA->endSlot - itemB->endSlot;
+    if (itemA->weight != itemB->weight) return itemB->weight - itemA->weight;
+    if (itemA->startSlot != itemB->startSlot) return itemB->startSlot - itemA->startSlot;
+    return itemA->index - itemB->index;
+}
+
+int optiFits(OptiLoad *load, OptiItem *item) {
+    for (int k = item->startSlot; k < item->endSlot; k++) {
+        if (load->bays[k] + item->needsBay > sites[calendar->site].bays) return 0;
+        for (int r = 0; r < MAX_RESOURCES; r++) {
+            if (load->resources[k][r] + item->demand[r] > sites[calendar->site].stock[r]) return 0;
+        }
+    }
+    return 1;
+}
+
+int optiFootprint(OptiItem *item) {
+    int perSlot = item->needsBay;
+    for (int r = 0; r < MAX_RESOURCES; r++) perSlot += item->demand[r];
+    return (item->endSlot - item->startSlot) * perSlot;
+}
+
+void optiApply(OptiLoad *load, OptiItem *item, int sign) {
+    for (int k = item->startSlot; k < item->endSlot; k++) {
+        load->bays[k] += sign * item->needsBay;
+        for (int r = 0; r < MAX_RESOURCES; r++) {
+            load->resources[k][r] += sign * item->demand[r];
+        }
+    }
+}
+
+// Picks the bookings to accept on one date. Bookings stay at their requested time, so
+// the only freedom is which subset to accept: a set fits iff no hour exceeds the bay
+// count or essential stock. Greedy by earliest end time gives the baseline, then a
+// bounded local search removes one accepted booking at a time and keeps the move if
+// the freed capacity admits more (or more valuable) rejected bookings, or the same
+// value with a smaller footprint. Each removal tried spends one move of *movesLeft, so the
+// result depends only on the input; the deadline is a safety cap for huge inputs.
+void optimizeDate(OptiItem *items, int n, int selected[], int *movesLeft, double deadline) {
+    OptiLoad load;
+    memset(&load, 0, sizeof(load));
+    qsort(items, n, sizeof(OptiItem), compareOptiItems);
+
+    for (int i = 0; i < n; i++) {
+        selected[i] = optiFits(&load, &items[i]);
+        if (selected[i]) optiApply(&load, &items[i], 1);
+    }
+
+    int improved = 1;
+    while (improved && *movesLeft > 0 && nowMs() < deadline) {
+        improved = 0;
+        for (int a = 0; a < n && *movesLeft > 0 && nowMs() < deadline; a++) {
+            if (!selected[a]) continue;
+            (*movesLeft)--;
+            optiApply(&load, &items[a], -1);
+            selected[a] = 0;
+
+            int added[MAX_PASS_BOOKINGS];
+            int addedCount = 0;
+            int gain = 0;
+            for (int r = 0; r < n; r++) {
+                if (r == a || selected[r] || !optiFits(&load, &items[r])) continue;
+                optiApply(&load, &items[r], 1);
+                selected[r] = 1;
+                added[addedCount++] = r;
+                gain += items[r].weight;
+            }
+
+            // Equal-value swaps are kept only when they free capacity, so the search cannot cycle.
+            if (gain > items[a].weight ||
+                (gain == items[a].weight && addedCount == 1 && optiFootprint(&items[added[0]]) < optiFootprint(&items[a]))) {
+                improved = 1;
+            } else {
+                for (int r = 0; r < addedCount; r++) {
+                    optiApply(&load, &items[added[r]], -1);
+                    selected[added[r]] = 0;
+                }
+                optiApply(&load, &items[a], 1);
+                selected[a] = 1;
+            }
+        }
+    }
+}
+
+void processBookings_Optimized() {
+    double deadline = nowMs() + optiTimeCapMs;
+    int movesLeft = optiMoveBudget;
+    resetAvailability();
+    schedulingIndex = totalBookings; // bays are assigned after selection, nothing is pending
+    setArrivalOrder();
+    int done[MAX_PASS_BOOKINGS] = {0};
+
+    // Bookings on different dates never compete, so each date is solved on its own.
+    for (int d = 0; d < totalBookings; d++) {
+        if (done[d]) continue;
+        const char *date = bookings[d].date;
+
+        OptiItem items[MAX_PASS_BOOKINGS];
+        int n = 0;
+        for (int i = d; i < totalBookings; i++) {
+            Booking *b = &bookings[i];
+            if (done[i] || strcmp(b->date, date) != 0) continue;
+            done[i] = 1;
+            int startMinutes = timeToMinutes(b->time);
+            OptiItem *item = &items[n++];
+            item->index = i;
+            item->startSlot = startMinutes / slotMinutes;
+            item->endSlot = slotEnd(startMinutes, durationToMinutes(b->duration));
+            item->needsBay = b->priority != PRIORITY_ESSENTIAL;
+            memcpy(item->demand, b->demand, sizeof(item->demand));
+            item->weight = bookingWeight(b->priority);
+        }
+
+        int selected[MAX_PASS_BOOKINGS];
+        optimizeDate(items, n, selected, &movesLeft, deadline);
+
+        // Assign bays in start order; since no hour is over capacity any bay free at the start
+        // hour stays free for the whole booking, so every bay policy finds one.
+        selectDay(date);
+        for (int s = 0; s < timeSlots; s++) {
+            for (int i = 0; i < n; i++) {
+                if (!selected[i] || items[i].startSlot != s) continue;
+                Booking *b = &bookings[items[i].index];
+                b->accepted = 1;
+                b->parkingSlot = -1;
+                adjustStock(items[i].startSlot, items[i].endSlot, items[i].demand, -1);
+                if (!items[i].needsBay) continue;
+                b->parkingSlot = chooseBay(b, items[i].startSlot, items[i].endSlot);
+                setBayRange(items[i].startSlot, items[i].endSlot, b->parkingSlot, 0);
+            }
+        }
+        calendar->days[currentDay].version++;
+
+        // The grids now hold this date's final schedule, which is what suggestions should see.
+        for (int i = 0; i < n; i++) {
+            if (selected[i]) continue;
+            Booking *b = &bookings[items[i].index];
+            int baysFull = 0;
+            for (int k = items[i].startSlot; k < items[i].endSlot && items[i].needsBay && !baysFull; k++) {
+                baysFull = 1;
+                for (int j = 0; j < sites[calendar->site].bays; j++) {
+                    if (parkingAvailability[k][j] != 0) baysFull = 0;
+                }
+            }
+            b->accepted = 0;
+            b->parkingSlot = -1;
+            b->reason = baysFull ? REASON_NO_BAY : REASON_ESSENTIALS;
+            b->suggestPending = 1;
+        }
+    }
+}
+
+// The original OPTIMIZED scheduler, kept so benchmarkOptimizer can compare against it.
+void processBookings_OptimizedLegacy() {
+    // Step 1: Run FCFS to get initial allocation
+    processBookings_FCFS();
+
+    // Step 2: Process rejected bookings with optimization
+    for (int m = 0; m < 5; m++) {
+        const char *member = members[m];
+        int rejectedBookings[MAX_PASS_BOOKINGS];
+        int rejectedCount = 0;
+
+        for (int i = 0; i < totalBookings; i++) {
+            Booking *b = &bookings[i];
+            if (strcmp(b->memberName, member) == 0 && !b->accepted) {
+                rejectedBookings[rejectedCount++] = i;
+            }
+        }
+
+        if (rejectedCount > 0) {
+            int durationMinutes = durationToMinutes(bookings[rejectedBookings[0]].duration);
+            int processed = 0;
+
+            for (int startMinutes = 0; startMinutes <= MINUTES_PER_DAY - durationMinutes && processed < rejectedCount; startMinutes += slotMinutes) {
+                // The replay stacks the accepted bookings on a state that already holds them; it
+                // is what this baseline measures, so it stays, but inside a transaction.
+                beginTransaction();
+                for (int j = 0; j < totalBookings; j++) {
+                    if (bookings[j].accepted) {
+                        int start = timeToMinutes(bookings[j].time);
+                        int dur = durationToMinutes(bookings[j].duration);
+                        allocateResources(start, dur, bookings[j].demand);
+                        if (bookings[j].priority != PRIORITY_ESSENTIAL) {
+                            setBayRange(start / slotMinutes, slotEnd(start, dur), bookings[j].parkingSlot, 0);
+                        }
+                    }
+                }
+
+                int bookingsToFit = 0;
+                int resourceCount[MAX_RESOURCES] = {0};
+                for (int r = 0; r < rejectedCount && processed + bookingsToFit < rejectedCount; r++) {
+                    Booking *b = &bookings[rejectedBookings[r + processed]];
+                    for (int k = 0; k < MAX_RESOURCES; k++) {
+                        if (strlen(b->essentials[k]) > 0) {
+                            int idx = getResourceIndex(b->essentials[k]);
+                            if (idx != -1) resourceCount[idx]++;
+                        }
+                    }
+                    int startSlot = startMinutes / slotMinutes;
+                    int endSlot = slotEnd(startMinutes, durationMinutes);
+                    int canFit = 1;
+                    for (int i = 0; i < MAX_RESOURCES; i++) {
+                        if (resourceCount[i] > 0) {
+                            for (int slot = startSlot; slot < endSlot; slot++) {
+                                if (resourceAvailability[slot][i] < resourceCount[i]) {
+                                    canFit = 0;
+                                    break;
+                                }
                             }
+                            if (!canFit) break;
+                        }
+                    }
+                    if (canFit) bookingsToFit++;
+                    else break;
+                }
+
+                if (bookingsToFit > 0) {
+                    int resourcesAllocated = allocateResources(startMinutes, durationMinutes, bookings[rejectedBookings[processed]].demand);
+                    if (resourcesAllocated) {
+                        // 記錄成功的時段
+                        OptimizedSlot *slot = &optimizedSlots[optimizedSlotCount++];
+                        strcpy(slot->date, bookings[rejectedBookings[processed]].date);
+                        slot->startMinutes = startMinutes;
+                        slot->durationMinutes = durationMinutes;
+                        memcpy(slot->resourceCount, resourceAvailability[startMinutes / slotMinutes], sizeof(resourceCount));
+
+                        for (int r = 0; r < bookingsToFit; r++) {
+                            Booking *b = &bookings[rejectedBookings[processed + r]];
+                            b->accepted = 1;
+                            sprintf(b->time, "%02d:%02d", startMinutes / 60, startMinutes % 60);
+                            b->reason = REASON_RESCHEDULED;
                         }
+                        processed += bookingsToFit;
+                        commitTransaction();
+                        continue;
+                    }
+                }
+                rollbackTransaction();
+            }
+
+            for (int r = processed; r < rejectedCount; r++) {
+                Booking *b = &bookings[rejectedBookings[r]];
+                b->accepted = 0;
+                b->reason = REASON_NO_SLOT;
+                b->suggestPending = 1;
+            }
+        }
+    }
+}
+
+// Orders the pass by priority class, keeping arrival order within a class, so PRIORITY passes
+// come out the same on every libc. A counting sort over the four classes fills passOrder in
+// linear time; the bookings themselves stay where they are.
+void sortByPriority() {
+    int start[PRIORITY_ESSENTIAL + 2] = {0};
+    for (int i = 0; i < totalBookings; i++) start[bookings[i].priority + 1]++;
+    for (int p = 1; p <= PRIORITY_ESSENTIAL; p++) start[p + 1] += start[p];
+    for (int i = 0; i < totalBookings; i++) passOrder[start[bookings[i].priority]++] = i;
+}
+
+// Demand vector of a list of essentials: one of every essential in the bundles of the listed ones.
+void computeResourceDemand(char essentials[MAX_RESOURCES][20], int demand[MAX_RESOURCES]) {
+    int mask = 0;
+    for (int i = 0; i < MAX_RESOURCES; i++) {
+        int r = essentials[i][0] != '\0' ? getResourceIndex(essentials[i]) : -1;
+        if (r != -1) mask |= bundleMask[r];
+    }
+    for (int r = 0; r < MAX_RESOURCES; r++) {
+        demand[r] = (mask >> r) & 1;
+    }
+}
+
+int allocateResources(int startMinutes, int durationMinutes, int demand[MAX_RESOURCES]) {
+    int startSlot = startMinutes / slotMinutes;
+    int endSlot = slotEnd(startMinutes, durationMinutes);
+
+    COUNT(allocateCalls);
+    if (!stockFits(startSlot, endSlot, demand)) {
+        COUNT(allocateFailures);
+        return 0;
+    }
+    adjustStock(startSlot, endSlot, demand, -1);
+    return 1;
+}
+
+void releaseResources(int startMinutes, int durationMinutes, int demand[MAX_RESOURCES]) {
+    int startSlot = startMinutes / slotMinutes;
+    int endSlot = slotEnd(startMinutes, durationMinutes);
+
+    COUNT(releaseCalls);
+    adjustStock(startSlot, endSlot, demand, 1);
+}
+
+void resetAvailability() {
+    calendar->dayCount = 0;
+    memset(calendar->suggestionCache, 0, sizeof(calendar->suggestionCache));
+    selectDay("");
+}
+
+void useCalendar(Calendar *target) {
+    calendar = target;
+    if (calendar->dayCount == 0) resetAvailability();
+    else selectDay(calendar->days[calendar->dayOrder[0]].date);
+}
+
+// Position in dayOrder of the first page dated on or after date.
+int dayOrderPosition(const char *date) {
+    int low = 0, high = calendar->dayCount;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (strcmp(calendar->days[calendar->dayOrder[mid]].date, date) < 0) low = mid + 1;
+        else high = mid;
+    }
+    return low;
+}
+
+// Makes the page of the given date current, creating it with every bay free and full stock.
+// Pages are found by binary search over dayOrder.
+int selectDay(const char *date) {
+    int low = dayOrderPosition(date);
+    int day;
+    if (low < calendar->dayCount && strcmp(calendar->days[calendar->dayOrder[low]].date, date) == 0) {
+        day = calendar->dayOrder[low];
+    } else {
+        if (calendar->dayCount == MAX_DAYS) reclaimBlankDay(&low);
+        day = calendar->dayCount++;
+        memmove(&calendar->dayOrder[low + 1], &calendar->dayOrder[low], (day - low) * sizeof(int));
+        calendar->dayOrder[low] = day;
+        DayCalendar *page = &calendar->days[day];
+        Site *site = &sites[calendar->site];
+        strcpy(page->date, date);
+        for (int i = 0; i < timeSlots; i++) {
+            memset(page->parking[i], 0, MAX_BAYS); // 0 means occupied, as bays the site lacks stay
+            memset(page->parking[i], 1, site->bays);
+            for (int j = 0; j < MAX_RESOURCES; j++) {
+                page->resources[i][j] = site->stock[j];
+            }
+        }
+        refreshDayMasks(page);
+        page->version++;
+        calendar->freeWindows[day].builtVersion = -1;
+    }
+    currentDay = day;
+    parkingAvailability = calendar->days[day].parking;
+    resourceAvailability = calendar->days[day].resources;
+    return day;
+}
+
+// Frees the table slot of a page that holds nothing, by moving the last page into it.
+// *position is the dayOrder insertion point of the caller and is kept valid.
+void reclaimBlankDay(int *position) {
+    for (int o = 0; o < calendar->dayCount; o++) {
+        DayCalendar *page = &calendar->days[calendar->dayOrder[o]];
+        Site *site = &sites[calendar->site];
+        int blank = 1;
+        for (int k = 0; k < timeSlots && blank; k++) {
+            for (int j = 0; j < site->bays && blank; j++) blank = page->parking[k][j] != 0;
+            for (int r = 0; r < MAX_RESOURCES && blank; r++) blank = page->resources[k][r] == site->stock[r];
+        }
+        // A page an open transaction wrote to must stay where its undo entries point.
+        for (int u = 0; u < undoCount && blank; u++) blank = undoLog[u].page != page;
+        if (!blank) continue;
+
+        removeDay(o);
+        if (o < *position) (*position)--;
+        return;
+    }
+}
+
+// Removes the page at position o of dayOrder, moving the last page into its table slot.
+void removeDay(int o) {
+    int freed = calendar->dayOrder[o];
+    int last = --calendar->dayCount;
+    memmove(&calendar->dayOrder[o], &calendar->dayOrder[o + 1], (last - o) * sizeof(int));
+    if (freed != last) {
+        calendar->days[freed] = calendar->days[last];
+        calendar->freeWindows[freed].builtVersion = -1;
+        for (int p = 0; p < last; p++) {
+            if (calendar->dayOrder[p] == last) calendar->dayOrder[p] = freed;
+        }
+    }
+    memset(calendar->suggestionCache, 0, sizeof(calendar->suggestionCache));
+}
+
+// First slot after the booking ends. The calendar is per date, so bookings are cut at midnight.
+int slotEnd(int startMinutes, int durationMinutes) {
+    int endMinutes = startMinutes + durationMinutes;
+    int endSlot = endMinutes / slotMinutes + (endMinutes % slotMinutes > 0 ? 1 : 0);
+    return endSlot > timeSlots ? timeSlots : endSlot;
+}
+
+void setBayRange(int startSlot, int endSlot, int bay, int value) {
+    uint64_t bit = bay < FAST_BAYS ? (uint64_t)1 << bay : 0;
+    for (int k = startSlot; k < endSlot; k++) {
+        if (transactionDepth > 0 && parkingAvailability[k][bay] != value) {
+            UndoEntry *entry = logUndo(&calendar->days[currentDay], UNDO_BAY);
+            if (entry) {
+                entry->startSlot = k;
+                entry->bay = bay;
+                entry->value = parkingAvailability[k][bay];
+            }
+        }
+        parkingAvailability[k][bay] = value;
+        if (value) calendar->days[currentDay].busyBays[k] &= ~bit;
+        else calendar->days[currentDay].busyBays[k] |= bit;
+    }
+    calendar->days[currentDay].version++;
+}
+
+// Rebuilds the run lengths of a day from its page, scanning each hour backwards once.
+void buildFreeWindowIndex(int day) {
+    DayCalendar *page = &calendar->days[day];
+    FreeWindowIndex *index = &calendar->freeWindows[day];
+    if (index->builtVersion == page->version) return;
+
+    int run[MAX_BAYS] = {0};
+    index->bayRun[timeSlots] = 0;
+    for (int k = timeSlots - 1; k >= 0; k--) {
+        index->bayRun[k] = 0;
+        for (int j = 0; j < sites[calendar->site].bays; j++) {
+            run[j] = page->parking[k][j] != 0 ? run[j] + 1 : 0;
+            if (run[j] > index->bayRun[k]) index->bayRun[k] = run[j];
+        }
+    }
+    for (int r = 0; r < MAX_RESOURCES; r++) {
+        for (int level = 0; level <= MAX_STOCK; level++) {
+            index->resourceRun[r][level][timeSlots] = 0;
+            for (int k = timeSlots - 1; k >= 0; k--) {
+                index->resourceRun[r][level][k] = page->resources[k][r] >= level ? index->resourceRun[r][level][k + 1] + 1 : 0;
+            }
+        }
+    }
+    index->builtVersion = page->version;
+}
+
+// Writes up to k feasible start hours on the day, nearest to requestedSlot first, into result.
+// Feasible starts are memoised per (day, duration, demand) until the day changes, so a repeat
+// query is a binary search plus k steps outwards. forSuggestion picks the counters the probes go
+// to: the suggestion ones, or the preemption ones when a displaced booking is being moved.
+int findNearestStarts(int day, int durationSlots, int needsBay, int demand[MAX_RESOURCES], int requestedSlot, int k, int result[], int forSuggestion) {
+    int demandKey = needsBay;
+    for (int r = 0; r < MAX_RESOURCES; r++) {
+        if (demand[r] > MAX_STOCK) return 0;
+        demandKey = demandKey * (MAX_STOCK + 1) + demand[r];
+    }
+    unsigned hash = ((unsigned)day * 31u + (unsigned)durationSlots * 17u + (unsigned)demandKey) % SUGGESTION_CACHE_SIZE;
+    SuggestionCacheEntry *entry = &calendar->suggestionCache[hash];
+
+    if (entry->version == calendar->days[day].version && entry->day == day &&
+        entry->durationSlots == durationSlots && entry->demandKey == demandKey) {
+        if (forSuggestion) COUNT(suggestionCacheHits);
+    } else if (useStockLanes() && (!needsBay || useBitsets())) {
+        uint64_t feasible[FEASIBLE_WORDS];
+        feasibleStarts(day, durationSlots, needsBay, demand, feasible);
+        entry->day = day;
+        entry->version = calendar->days[day].version;
+        entry->durationSlots = durationSlots;
+        entry->demandKey = demandKey;
+        entry->count = 0;
+        for (int w = 0; w < FEASIBLE_WORDS; w++) {
+            if (forSuggestion) COUNT(suggestionProbes);
+            else COUNT(preemptionProbes);
+            for (uint64_t bits = feasible[w]; bits; bits &= bits - 1) {
+                entry->starts[entry->count++] = w * 64 + __builtin_ctzll(bits);
+            }
+        }
+    } else {
+        buildFreeWindowIndex(day);
+        FreeWindowIndex *index = &calendar->freeWindows[day];
+        entry->day = day;
+        entry->version = calendar->days[day].version;
+        entry->durationSlots = durationSlots;
+        entry->demandKey = demandKey;
+        entry->count = 0;
+        for (int s = 0; s + durationSlots <= timeSlots; s++) {
+            if (forSuggestion) COUNT(suggestionProbes);
+            else COUNT(preemptionProbes);
+            int feasible = !needsBay || index->bayRun[s] >= durationSlots;
+            for (int r = 0; r < MAX_RESOURCES && feasible; r++) {
+                if (demand[r] > 0 && index->resourceRun[r][demand[r]][s] < durationSlots) feasible = 0;
+            }
+            if (feasible) entry->starts[entry->count++] = s;
+        }
+    }
+
+    int low = 0, high = entry->count;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (entry->starts[mid] < requestedSlot) low = mid + 1;
+        else high = mid;
+    }
+    int left = low - 1, right = low, found = 0;
+    while (found < k && (left >= 0 || right < entry->count)) {
+        if (right < entry->count && entry->starts[right] == requestedSlot) {
+            right++;
+        } else if (left < 0 || (right < entry->count && entry->starts[right] - requestedSlot <= requestedSlot - entry->starts[left])) {
+            result[found++] = entry->starts[right++];
+        } else {
+            result[found++] = entry->starts[left--];
+        }
+    }
+    return found;
+}
+
+// Fills result with what site has free from startMinutes to endMinutes on every date from fromDate
+// to toDate. Dates without a page are untouched, so only the pages in the range are read: a binary
+// search, then per page the bitsets of the window (or the cells, for sites with many bays).
+// Returns NULL, or what is wrong with the query.
+const char* queryAvailability(int site, const char *fromDate, const char *toDate, int startMinutes, int endMinutes, Availability *result) {
+    if (site < 0 || site >= siteCount) return "Unknown site";
+    if (!isValidDate((char *)fromDate) || !isValidDate((char *)toDate) || strcmp(fromDate, toDate) > 0) {
+        return "Invalid date range (Expected: YYYY-MM-DD [YYYY-MM-DD], in order)";
+    }
+    if (startMinutes < 0 || endMinutes > MINUTES_PER_DAY || startMinutes >= endMinutes) {
+        return "Invalid time window (Expected: hh:mm hh:mm, start before end, within the day)";
+    }
+    if (!expandLiveDays(dateToDay(fromDate), dateToDay(toDate))) {
+        return "Too many recurring occurrences held live (Maximum: 200). Query fewer dates or expire older bookings";
+    }
+    Site *capacity = &sites[site];
+    result->bays = result->fewestBays = capacity->bays;
+    for (int r = 0; r < MAX_RESOURCES; r++) result->stock[r] = capacity->stock[r];
+
+    Calendar *savedCalendar = calendar;
+    useCalendar(&liveCalendars[site]);
+    int startSlot = startMinutes / slotMinutes, endSlot = slotEnd(startMinutes, endMinutes - startMinutes);
+    uint64_t siteBays = capacity->bays >= 64 ? ~0ULL : ((uint64_t)1 << capacity->bays) - 1;
+    for (int position = dayOrderPosition(fromDate); position < calendar->dayCount; position++) {
+        DayCalendar *page = &calendar->days[calendar->dayOrder[position]];
+        if (strcmp(page->date, toDate) > 0) break;
+        if (page->date[0] == 0) continue; // the blank page of resetAvailability
+        int freeThroughout = 0;
+        if (capacity->bays <= FAST_BAYS) {
+            uint64_t busy = 0;
+            for (int k = startSlot; k < endSlot; k++) {
+                int freeNow = __builtin_popcountll(~page->busyBays[k] & siteBays);
+                if (freeNow < result->fewestBays) result->fewestBays = freeNow;
+                busy |= page->busyBays[k];
+            }
+            freeThroughout = __builtin_popcountll(~busy & siteBays);
+        } else {
+            for (int k = startSlot; k < endSlot; k++) {
+                int freeNow = 0;
+                for (int j = 0; j < capacity->bays; j++) freeNow += page->parking[k][j] != 0;
+                if (freeNow < result->fewestBays) result->fewestBays = freeNow;
+            }
+            for (int j = 0; j < capacity->bays; j++) {
+                int free = 1;
+                for (int k = startSlot; k < endSlot && free; k++) free = page->parking[k][j] != 0;
+                freeThroughout += free;
+            }
+        }
+        if (freeThroughout < result->bays) result->bays = freeThroughout;
+        for (int k = startSlot; k < endSlot; k++) {
+            for (int r = 0; r < essentialCount; r++) {
+                if (page->resources[k][r] < result->stock[r]) result->stock[r] = page->resources[k][r];
+            }
+        }
+    }
+    useCalendar(savedCalendar);
+    return NULL;
+}
+
+// queryAvailability YYYY-MM-DD [YYYY-MM-DD] hh:mm hh:mm [@site]
+void printAvailability(const char *args) {
+    char fromDate[11] = "", toDate[11] = "", from[6] = "", to[6] = "", extra[6] = "";
+    int fields = sscanf(args, " %10s %10s %5s %5s", fromDate, toDate, from, to);
+    if (fields == 3 && strchr(toDate, ':') != NULL) { // no end date
+        strcpy(extra, from);
+        strcpy(from, toDate);
+        strcpy(to, extra);
+        strcpy(toDate, fromDate);
+    } else if (fields != 4) {
+        printf("Usage: queryAvailability YYYY-MM-DD [YYYY-MM-DD] hh:mm hh:mm [@site]\n");
+        return;
+    }
+    int hour, minute;
+    if (sscanf(from, "%d:%d", &hour, &minute) != 2 || sscanf(to, "%d:%d", &hour, &minute) != 2) {
+        printf("Invalid time window (Expected: hh:mm hh:mm, start before end, within the day)\n");
+        return;
+    }
+
+    Availability found[MAX_SITES];
+    double started = nowMs();
+    for (int s = 0; s < siteCount; s++) {
+        if (requestedSite != SITE_ANY && requestedSite != s) continue;
+        const char *error = queryAvailability(s, fromDate, toDate, timeToMinutes(from), timeToMinutes(to), &found[s]);
+        if (error != NULL) {
+            printf("%s\n", error);
+            return;
+        }
+    }
+    double elapsed = nowMs() - started;
+
+    if (strcmp(fromDate, toDate) == 0) printf("Free on %s from %s to %s:\n", fromDate, from, to);
+    else printf("Free on every date from %s to %s, from %s to %s:\n", fromDate, toDate, from, to);
+    for (int s = 0; s < siteCount; s++) {
+        if (requestedSite != SITE_ANY && requestedSite != s) continue;
+        printf("    %-10s %d of %d bays throughout (fewest at once: %d)", sites[s].name, found[s].bays, sites[s].bays, found[s].fewestBays);
+        for (int r = 0; r < essentialCount; r++) {
+            printf(", %s %d/%d", resourceNames[r], found[s].stock[r], sites[s].stock[r]);
+        }
+        printf("\n");
+    }
+    printf("(answered in %.3f ms)\n", elapsed);
+}
+
+char* calculateEndTime(const char* startTime, float duration) {
+    int startHour, startMin;
+    sscanf(startTime, "%d:%d", &startHour, &startMin);
+    int totalMin = startHour * 60 + startMin + (int)(duration * 60);
+    int endHour = totalMin / 60 % 24;
+    int endMin = totalMin % 60;
+    char* endTime = (char*)malloc(6 * sizeof(char));
+    sprintf(endTime, "%02d:%02d", endHour, endMin);
+    return endTime;
+}
+
+const char* getReasonText(int reason) {
+    switch (reason) {
+        case REASON_ESSENTIALS: return "One or more essentials unavailable.";
+        case REASON_NO_BAY: return "No available parking slots.";
+        case REASON_DISPLACED: return "Displaced by higher priority booking.";
+        case REASON_RESCHEDULED: return "Rescheduled to optimized slot";
+        case REASON_NO_SLOT: return "No suitable slot found with available resources";
+        case REASON_MOVED: return "Moved to make room for a higher priority booking.";
+        default: return "";
+    }
+}
+
+const char* getBookingType(int priority) {
+    switch (priority) {
+        case PRIORITY_EVENT: return "Event";
+        case PRIORITY_RESERVATION: return "Reservation";
+        case PRIORITY_PARKING: return "Parking";
+        case PRIORITY_ESSENTIAL: return "Essentials";
+        default: return "Unknown";
+    }
+}
+
+void printBookings(const char *algorithm) {
+    PHASE_BEGIN(PHASE_REPORT);
+    printf("\n*** Booking Schedule (%s) ***\n", algorithm);
+
+    char members[5][20] = {"member_A", "member_B", "member_C", "member_D", "member_E"};
+
+    printf("\n*** ACCEPTED Bookings ***\n");
+    for (int m = 0; m < 5; m++) {
+        char *member = members[m];
+        int hasBookings = 0;
+        for (int i = 0; i < totalBookings; i++) {
+            Booking *b = &bookings[i];
+            if (strcmp(b->memberName, member) == 0 && b->accepted) {
+                if (!hasBookings) {
+                    printf("%s has the following bookings:\n", member);
+                    printf("%-12s %-6s %-6s %-12s %-20s", "Date", "Start", "End", "Type", "Device");
+                    if (siteCount > 1) printf(" %-10s", "Site");
+                    printf("\n");
+                    printf("===============================================================\n");
+                    hasBookings = 1;
+                }
+                char *endTime = calculateEndTime(b->time, b->duration);
+                char devices[100] = "";
+                for (int j = 0; j < MAX_RESOURCES; j++) {
+                    if (strlen(b->essentials[j]) > 0) {
+                        strcat(devices, b->essentials[j]);
+                        strcat(devices, ", ");
                     }
                 }
+                if (strlen(devices) > 0) devices[strlen(devices) - 2] = '\0';
+                else strcpy(devices, "*");
+                printf("%-12s %-6s %-6s %-12s %-20s", b->date, b->time, endTime, getBookingType(b->priority), devices);
+                if (siteCount > 1) printf(" %-10s", sites[b->assignedSite].name);
+                // Schedules printed here come from scheduleSites, so passIndex names the request.
+                if (b->reason == REASON_MOVED) printf(" (moved from %s)", initialBookings[b->passIndex].time);
+                printf("\n");
+                free(endTime);
+            }
+        }
+        if (hasBookings) printf("\n");
+    }
+    printf("- End -\n");
 
-                int bookingsToFit = 0;
-                int resourceCount[MAX_RESOURCES] = {0};
-                for (int r = 0; r < rejectedCount && processed + bookingsToFit < rejectedCount; r++) {
-                    Booking *b = &bookings[rejectedBookings[r + processed]];
-                    for (int k = 0; k < MAX_RESOURCES; k++) {
-                        if (strlen(b->essentials[k]) > 0) {
-                            int idx = getResourceIndex(b->essentials[k]);
-                            if (idx != -1) resourceCount[idx]++;
-                        }
-                    }
-                    int startSlot = startMinutes / 60;
-                    int endSlot = (startMinutes + durationMinutes) / 60 + ((startMinutes + durationMinutes) % 60 > 0 ? 1 : 0);
-                    int canFit = 1;
-                    for (int i = 0; i < MAX_RESOURCES; i++) {
-                        if (resourceCount[i] > 0) {
-                            for (int slot = startSlot; slot < endSlot; slot++) {
-                                if (resourceAvailability[slot][i] < resourceCount[i]) {
-                                    canFit = 0;
-                                    break;
-                                }
-                            }
-                            if (!canFit) break;
+    printf("\n*** Parking Booking - REJECTED / %s ***\n", algorithm);
+    for (int m = 0; m < 5; m++) {
+        char *member = members[m];
+        int rejectedCount = 0;
+        for (int i = 0; i < totalBookings; i++) {
+            if (strcmp(bookings[i].memberName, member) == 0 && !bookings[i].accepted) {
+                rejectedCount++;
+            }
+        }
+        if (rejectedCount > 0) {
+            printf("%s (there are %d bookings rejected):\n", member, rejectedCount);
+            printf("%-12s %-6s %-6s %-12s %-20s", "Date", "Start", "End", "Type", "Essentials");
+            if (siteCount > 1) printf(" %-10s", "Site");
+            printf(" %-30s\n", "Reason");
+            printf("================================================================================\n");
+            for (int i = 0; i < totalBookings; i++) {
+                Booking *b = &bookings[i];
+                if (strcmp(b->memberName, member) == 0 && !b->accepted) {
+                    char *endTime = calculateEndTime(b->time, b->duration);
+                    char essentials[100] = "";
+                    for (int j = 0; j < MAX_RESOURCES; j++) {
+                        if (strlen(b->essentials[j]) > 0) {
+                            strcat(essentials, b->essentials[j]);
+                            strcat(essentials, ", ");
                         }
                     }
-                    if (canFit) bookingsToFit++;
-                    else break;
+                    if (strlen(essentials) > 0) essentials[strlen(essentials) - 2] = '\0';
+                    else strcpy(essentials, "-");
+                    printf("%-12s %-6s %-6s %-12s %-20s", b->date, b->time, endTime, getBookingType(b->priority), essentials);
+                    if (siteCount > 1) printf(" %-10s", sites[b->assignedSite].name);
+                    printf(" %-30s\n", getReasonText(b->reason));
+                    free(endTime);
                 }
+            }
+            printf("\n");
+        }
+    }
+    printf("- End -\n");
+    PHASE_END(PHASE_REPORT);
+}
 
-                if (bookingsToFit > 0) {
-                    int resourcesAllocated = allocateResources(startMinutes, durationMinutes, bookings[rejectedBookings[processed]].essentials);
-                    if (resourcesAllocated) {
-                        // 記錄成功的時段
-                        OptimizedSlot *slot = &optimizedSlots[optimizedSlotCount++];
-                        strcpy(slot->date, bookings[rejectedBookings[processed]].date);
-                        slot->startMinutes = startMinutes;
-                        slot->durationMinutes = durationMinutes;
-                        memcpy(slot->resourceCount, resourceAvailability[startMinutes / 60], sizeof(resourceCount));
+void generateSummaryReport() {
+    PHASE_BEGIN(PHASE_SUMMARY);
+    Booking originalBookings[MAX_PASS_BOOKINGS];
+    
+    // Save the original state of bookings
+    memcpy(originalBookings, initialBookings, sizeof(bookings));
 
-                        for (int r = 0; r < bookingsToFit; r++) {
-                            Booking *b = &bookings[rejectedBookings[processed + r]];
-                            b->accepted = 1;
-                            sprintf(b->time, "%02d:%02d", startMinutes / 60, startMinutes % 60);
-                            snprintf(b->reasonForRejection, sizeof(b->reasonForRejection), "Rescheduled to optimized slot");
-                        }
-                        processed += bookingsToFit;
-                        memcpy(tempParking, parkingAvailability, sizeof(parkingAvailability));
-                        memcpy(tempResources, resourceAvailability, sizeof(resourceAvailability));
-                    }
+    // Usage of each algorithm comes from the passes printed just before; run any that were not.
+    void (*schedulers[3])() = {processBookings_FCFS, processBookings_Priority, processBookings_Optimized};
+    float siteFragmentation[MAX_SITES];
+    suggestionsEnabled = 0; // nothing here prints the rejections
+    for (int a = 0; a < 3; a++) {
+        if (passUsage[a].recorded) continue;
+        memcpy(bookings, originalBookings, sizeof(bookings));
+        scheduleSites(schedulers[a], siteFragmentation);
+        recordUsage(&passUsage[a], siteFragmentation);
+    }
+    suggestionsEnabled = 1;
+    int fcfsAccepted = passUsage[0].accepted, prioAccepted = passUsage[1].accepted, optiAccepted = passUsage[2].accepted;
+    float fcfsFragmentation = passUsage[0].fragmentation;
+    float prioFragmentation = passUsage[1].fragmentation;
+    float optiFragmentation = passUsage[2].fragmentation;
+
+    // Essential-minutes used out of the essential-minutes all sites offer over the date range.
+    int days = passUsage[0].lastDay - passUsage[0].firstDay + 1;
+    float fcfsUtilization[MAX_RESOURCES];
+    float prioUtilization[MAX_RESOURCES];
+    float optiUtilization[MAX_RESOURCES];
+    for (int i = 0; i < MAX_RESOURCES; i++) {
+        float available = 0;
+        for (int s = 0; s < siteCount; s++) available += sites[s].stock[i] * (float)MINUTES_PER_DAY * days;
+        fcfsUtilization[i] = available > 0 ? passUsage[0].resourceMinutes[i] / available * 100 : 0;
+        prioUtilization[i] = available > 0 ? passUsage[1].resourceMinutes[i] / available * 100 : 0;
+        optiUtilization[i] = available > 0 ? passUsage[2].resourceMinutes[i] / available * 100 : 0;
+    }
+
+    // Print the report
+    printf("\n*** Parking Booking Manager - Summary Report ***\n");
+    printf("Performance:\n");
+    printf("For FCFS:\n");
+    printf("    Total Number of Bookings Received: %d (100%%)\n", totalBookings);
+    printf("    Number of Bookings Assigned: %d (%.1f%%)\n", fcfsAccepted, (float)fcfsAccepted / totalBookings * 100);
+    printf("    Number of Bookings Rejected: %d (%.1f%%)\n", totalBookings - fcfsAccepted, (float)(totalBookings - fcfsAccepted) / totalBookings * 100);
+    if (passUsage[0].moved > 0) printf("    Number of Bookings Moved: %d\n", passUsage[0].moved);
+    printf("    Utilization of Time slot:\n");
+    for (int i = 0; i < essentialCount; i++) {
+        printf("    %s - %.1f%%\n", resourceNames[i], fcfsUtilization[i]);
+    }
+    printf("    Bay fragmentation (%s): %.1f%%\n", getBayPolicyName(bayPolicy), fcfsFragmentation);
+    printf("    Invalid request(s) made: 0\n");
+
+    printf("For PRIO:\n");
+    printf("    Total Number of Bookings Received: %d (100%%)\n", totalBookings);
+    printf("    Number of Bookings Assigned: %d (%.1f%%)\n", prioAccepted, (float)prioAccepted / totalBookings * 100);
+    printf("    Number of Bookings Rejected: %d (%.1f%%)\n", totalBookings - prioAccepted, (float)(totalBookings - prioAccepted) / totalBookings * 100);
+    if (passUsage[1].moved > 0) printf("    Number of Bookings Moved: %d\n", passUsage[1].moved);
+    printf("    Utilization of Time slot:\n");
+    for (int i = 0; i < essentialCount; i++) {
+        printf("    %s - %.1f%%\n", resourceNames[i], prioUtilization[i]);
+    }
+    printf("    Bay fragmentation (%s): %.1f%%\n", getBayPolicyName(bayPolicy), prioFragmentation);
+    printf("    Invalid request(s) made: 0\n");
+
+    printf("For OPTI:\n");
+    printf("    Total Number of Bookings Received: %d (100%%)\n", totalBookings);
+    printf("    Number of Bookings Assigned: %d (%.1f%%)\n", optiAccepted, (float)optiAccepted / totalBookings * 100);
+    printf("    Number of Bookings Rejected: %d (%.1f%%)\n", totalBookings - optiAccepted, (float)(totalBookings - optiAccepted) / totalBookings * 100);
+    printf("    Utilization of Time slot:\n");
+    for (int i = 0; i < essentialCount; i++) {
+        printf("    %s - %.1f%%\n", resourceNames[i], optiUtilization[i]);
+    }
+    printf("    Bay fragmentation (%s): %.1f%%\n", getBayPolicyName(bayPolicy), optiFragmentation);
+    printf("    Invalid request(s) made: 0\n");
+
+    // Bay-minutes used out of the bay-minutes each site offers over the date range.
+    printf("Site Utilization (bay-hours used / available, %d day(s)):\n", days);
+    printf("    %-12s %-6s %-10s %-10s %-10s\n", "Site", "Bays", "FCFS", "PRIO", "OPTI");
+    for (int s = 0; s < siteCount; s++) {
+        float available = sites[s].bays * (float)MINUTES_PER_DAY * days;
+        printf("    %-12s %-6d", sites[s].name, sites[s].bays);
+        for (int a = 0; a < 3; a++) {
+            char cell[16] = "-";
+            if (available > 0) snprintf(cell, sizeof(cell), "%.1f%%", passUsage[a].bayMinutes[s] / available * 100);
+            printf(" %-10s", cell);
+        }
+        printf("\n");
+    }
+    printf("Waitlist (bookings that did not fit when submitted):\n");
+    printf("    Waitlisted: %d, promoted: %d, still waiting: %d\n", waitlistedCount, promotedCount, waitCount);
+    if (waitlistedCount > 0) printf("    Fill rate: %.1f%%\n", (float)promotedCount / waitlistedCount * 100);
+    else printf("    Fill rate: -\n");
+    printHeatmap(&passUsage[0], "FCFS");
+    printHeatmap(&passUsage[1], "PRIO");
+    printHeatmap(&passUsage[2], "OPTI");
+
+    // Acceptance and fragmentation of every bay policy, without suggestions cluttering the report.
+    int savedPolicy = bayPolicy;
+    suggestionsEnabled = 0;
+    printf("Bay Assignment Policies (assigned / fragmentation):\n");
+    printf("    %-12s %-16s %-16s %-16s\n", "Policy", "FCFS", "PRIO", "OPTI");
+    for (int p = 0; p < BAY_POLICY_COUNT; p++) {
+        char cells[3][32];
+        bayPolicy = p;
+        for (int a = 0; a < 3; a++) {
+            memcpy(bookings, originalBookings, sizeof(bookings));
+            scheduleSites(schedulers[a], siteFragmentation);
+            int accepted = 0;
+            for (int i = 0; i < totalBookings; i++) {
+                if (bookings[i].accepted) accepted++;
+            }
+            snprintf(cells[a], sizeof(cells[a]), "%d / %.1f%%", accepted, meanFragmentation(siteFragmentation));
+        }
+        printf("    %-12s %-16s %-16s %-16s\n", getBayPolicyName(p), cells[0], cells[1], cells[2]);
+    }
+    suggestionsEnabled = 1;
+    bayPolicy = savedPolicy;
+
+    // Restore original state (the schedules themselves are only ever held by the child processes)
+    memcpy(bookings, originalBookings, sizeof(bookings));
+    resetAvailability();
+    PHASE_END(PHASE_SUMMARY);
+}
+
+int timeToMinutes(char *time) {
+    int hour, minute;
+    sscanf(time, "%d:%d", &hour, &minute);
+    return hour * 60 + minute;
+}
+
+int durationToMinutes(float duration) {
+    return (int)(duration * 60); 
+}
+
+int getResourceIndex(const char *resourceName) {
+    for (int i = 0; i < essentialCount; i++) {
+        if (strcmp(resourceNames[i], resourceName) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int contains(char essentials[MAX_RESOURCES][20], const char *item) {
+    for (int i = 0; i < MAX_RESOURCES; i++) {
+        if (strcmp(essentials[i], item) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Suggestions of the bookings rejected in the pass just scheduled, worked out on the finished
+// schedule: once no later booking can take the slots they point to, and with every query on a
+// day hitting the same calendar version (so repeated ones come from the suggestion cache).
+void printPendingSuggestions() {
+    for (int i = 0; i < totalBookings; i++) {
+        Booking *b = &bookings[passOrder[i]];
+        if (b->suggestPending && !b->accepted) suggestAlternativeSlots(b);
+        b->suggestPending = 0;
+    }
+}
+
+// suggestSlots -<handle>: where a waiting booking would fit in the live calendars right now.
+void suggestForHandle(int handle) {
+    int i = findBookingByHandle(handle);
+    if (i == -1) {
+        printf("Booking #%d not found.\n", handle);
+        return;
+    }
+    if (liveEntries[i].status == LIVE_ADMITTED) {
+        printf("Booking #%d already holds its slot.\n", handle);
+        return;
+    }
+    Calendar *savedCalendar = calendar;
+    for (int s = 0; s < siteCount; s++) {
+        if (initialBookings[i].site != SITE_ANY && initialBookings[i].site != s) continue;
+        if (siteCount > 1) printf("At %s:\n", sites[s].name);
+        useCalendar(&liveCalendars[s]);
+        suggestAlternativeSlots(&initialBookings[i]);
+    }
+    useCalendar(savedCalendar);
+}
+
+void suggestAlternativeSlots(Booking *b) {
+    COUNT(suggestionCalls);
+    int startMinutes = timeToMinutes(b->time);
+    int offset = startMinutes % slotMinutes;
+    int durationSlots = slotEnd(offset, durationToMinutes(b->duration));
+    int starts[SUGGESTION_COUNT];
+    int day = selectDay(b->date);
+    int suggestions = findNearestStarts(day, durationSlots, b->priority != PRIORITY_ESSENTIAL, b->demand,
+                                        startMinutes / slotMinutes, SUGGESTION_COUNT, starts, 1);
+
+    printf("Suggested alternative booking slots for %s on %s at %s:\n", b->memberName, b->date, b->time);
+    for (int i = 0; i < suggestions; i++) {
+        int minutes = starts[i] * slotMinutes + offset;
+        printf(" -> Time slot: %02d:%02d\n", minutes / 60, minutes % 60);
+    }
+    if (suggestions == 0) {
+        printf(" -> No suitable slots available.\n");
+    }
+}
+
+double nowMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// Runs the legacy and current OPTIMIZED schedulers on the loaded bookings from a clean
+// state and compares acceptance, priority-weighted score and runtime. Legacy counts
+// bookings it silently moved to another time as accepted; they are listed separately.
+void benchmarkOptimizer() {
+    const int runs = 20;
+    const char *names[2] = {"LEGACY", "OPTIMIZED"};
+    void (*schedulers[2])() = {processBookings_OptimizedLegacy, processBookings_Optimized};
+    Booking savedBookings[MAX_PASS_BOOKINGS];
+    memcpy(savedBookings, bookings, sizeof(bookings));
+    suggestionsEnabled = 0;
+
+    printf("\n*** Optimizer Benchmark (%d bookings, %d runs, budget %d moves) ***\n", totalBookings, runs, optiMoveBudget);
+    printf("%-12s %-10s %-8s %-10s %-12s %-10s %-10s\n", "Algorithm", "Accepted", "Rate", "Weighted", "Rescheduled", "As asked", "Avg ms");
+    printf("===========================================================================\n");
+    for (int a = 0; a < 2; a++) {
+        double totalMs = 0;
+        for (int r = 0; r < runs; r++) {
+            memcpy(bookings, initialBookings, sizeof(bookings));
+            resetAvailability();
+            optimizedSlotCount = 0;
+            double start = nowMs();
+            schedulers[a]();
+            totalMs += nowMs() - start;
+        }
+        int accepted = 0, weighted = 0, rescheduled = 0;
+        for (int i = 0; i < totalBookings; i++) {
+            if (!bookings[i].accepted) continue;
+            accepted++;
+            weighted += PRIORITY_ESSENTIAL + 1 - bookings[i].priority;
+            if (strcmp(bookings[i].time, initialBookings[i].time) != 0) rescheduled++;
+        }
+        char rate[16];
+        snprintf(rate, sizeof(rate), "%.1f%%", (float)accepted / totalBookings * 100);
+        // Only the bookings kept at their requested time compare like for like: OPTIMIZED never moves one.
+        printf("%-12s %-10d %-8s %-10d %-12d %-10d %-10.3f\n", names[a], accepted, rate, weighted, rescheduled,
+               accepted - rescheduled, totalMs / runs);
+    }
+
+    suggestionsEnabled = 1;
+    optimizedSlotCount = 0;
+    resetAvailability();
+    memcpy(bookings, savedBookings, sizeof(bookings));
+}
+
+// Runs FCFS and PRIORITY on the loaded bookings with the legacy and cascading preemption rules
+// and compares evictions, re-placements and final acceptance.
+void comparePreemption() {
+    const char *names[2] = {"FCFS", "PRIORITY"};
+    const char *modes[2] = {"LEGACY", "CASCADE"};
+    void (*schedulers[2])() = {processBookings_FCFS, processBookings_Priority};
+    Booking savedBookings[MAX_PASS_BOOKINGS];
+    memcpy(savedBookings, bookings, sizeof(bookings));
+    int savedMode = preemptionMode;
+    suggestionsEnabled = 0;
+
+    printf("\n*** Preemption Comparison (%d bookings) ***\n", totalBookings);
+    printf("%-10s %-9s %-10s %-8s %-10s %-10s %-8s\n", "Algorithm", "Mode", "Accepted", "Rate", "Evictions", "Re-placed", "Dropped");
+    printf("=====================================================================\n");
+    for (int a = 0; a < 2; a++) {
+        for (int m = 0; m < 2; m++) {
+            memcpy(bookings, initialBookings, sizeof(bookings));
+            resetAvailability();
+            preemptionMode = m == 0 ? PREEMPT_LEGACY : PREEMPT_CASCADE;
+            schedulers[a]();
+            int accepted = 0;
+            for (int i = 0; i < totalBookings; i++) {
+                if (bookings[i].accepted) accepted++;
+            }
+            char rate[16];
+            snprintf(rate, sizeof(rate), "%.1f%%", (float)accepted / totalBookings * 100);
+            printf("%-10s %-9s %-10d %-8s %-10d %-10d %-8d\n", names[a], modes[m], accepted, rate,
+                   evictionCount, replacedCount, droppedCount);
+        }
+    }
+
+    preemptionMode = savedMode;
+    suggestionsEnabled = 1;
+    resetAvailability();
+    memcpy(bookings, savedBookings, sizeof(bookings));
+}
+
+// Sets the capacities of every site for scenario number scenario of the grid. Returns an error
+// (and leaves sites[] partly changed) if a value falls outside the compiled-in ceilings.
+const char* applyScenario(SimAxis axes[], int axisCount, int scenario, char *label, size_t labelSize) {
+    int chosen[SIM_MAX_AXES];
+    for (int a = axisCount - 1; a >= 0; a--) {
+        chosen[a] = scenario % axes[a].count;
+        scenario /= axes[a].count;
+    }
+    int used = 0;
+    label[0] = '\0';
+    for (int a = 0; a < axisCount; a++) {
+        int v = chosen[a];
+        const char *name = axes[a].target == SIM_BAYS ? "bays" : axes[a].target == SIM_STOCK ? "stock" : resourceNames[axes[a].target];
+        used += snprintf(label + used, labelSize - used, axes[a].relative[v] ? "%s%s %+d" : "%s%s %d", a > 0 ? ", " : "", name, axes[a].values[v]);
+        if (used >= (int)labelSize) used = labelSize - 1;
+    }
+
+    for (int a = 0; a < axisCount; a++) {
+        int v = chosen[a];
+        for (int s = 0; s < siteCount; s++) {
+            for (int r = 0; r < essentialCount; r++) {
+                if (axes[a].target >= 0 && axes[a].target != r) continue;
+                int *cell = axes[a].target == SIM_BAYS ? &sites[s].bays : &sites[s].stock[r];
+                *cell = axes[a].relative[v] ? *cell + axes[a].values[v] : axes[a].values[v];
+                if (axes[a].target == SIM_BAYS) {
+                    if (*cell < 1 || *cell > MAX_BAYS) return "bays out of range";
+                    break;
                 }
+                if (*cell < 0 || *cell > MAX_STOCK) return "stock out of range";
             }
+        }
+    }
+    return NULL;
+}
 
-            for (int r = processed; r < rejectedCount; r++) {
-                Booking *b = &bookings[rejectedBookings[r]];
-                b->accepted = 0;
-                snprintf(b->reasonForRejection, sizeof(b->reasonForRejection), "No suitable slot found with available resources");
-                suggestAlternativeSlots(b->duration, b->memberName, b->date, b->time);
+// Runs the three schedulers on the pass bookings with the current capacities (routing them to
+// sites again first) and measures acceptance and utilization.
+void simulateScenario(SimResult *result) {
+    void (*schedulers[3])() = {processBookings_FCFS, processBookings_Priority, processBookings_Optimized};
+    Booking passBookings[MAX_PASS_BOOKINGS];
+    routeBookings();
+    memcpy(passBookings, bookings, sizeof(bookings));
+
+    int dates = 0;
+    for (int i = 0; i < totalBookings; i++) {
+        int first = 1;
+        for (int j = 0; j < i && first; j++) first = strcmp(passBookings[j].date, passBookings[i].date) != 0;
+        dates += first;
+    }
+    float bayHoursAvailable = 0, essentialHoursAvailable = 0;
+    for (int s = 0; s < siteCount; s++) {
+        bayHoursAvailable += sites[s].bays * MINUTES_PER_DAY / 60.0 * dates;
+        for (int r = 0; r < essentialCount; r++) essentialHoursAvailable += sites[s].stock[r] * MINUTES_PER_DAY / 60.0 * dates;
+    }
+
+    for (int a = 0; a < 3; a++) {
+        memcpy(bookings, passBookings, sizeof(bookings));
+        scheduleSites(schedulers[a], NULL);
+        int accepted = 0;
+        float bayHours = 0, essentialHours = 0;
+        for (int i = 0; i < totalBookings; i++) {
+            Booking *b = &bookings[i];
+            if (!b->accepted) continue;
+            accepted++;
+            int startMinutes = timeToMinutes(b->time);
+            int minutes = durationToMinutes(b->duration);
+            if (startMinutes + minutes > MINUTES_PER_DAY) minutes = MINUTES_PER_DAY - startMinutes; // cut at midnight
+            if (b->priority != PRIORITY_ESSENTIAL) bayHours += minutes / 60.0;
+            for (int r = 0; r < essentialCount; r++) essentialHours += b->demand[r] * minutes / 60.0;
+        }
+        result->accepted[a] = (float)accepted / totalBookings * 100;
+        result->bayUse[a] = bayHoursAvailable > 0 ? bayHours / bayHoursAvailable * 100 : 0;
+        result->essentialUse[a] = essentialHoursAvailable > 0 ? essentialHours / essentialHoursAvailable * 100 : 0;
+    }
+}
+
+// simulate -bays 10,20,+50 -stock 3,+2 -battery 5 [YYYY-MM-DD [YYYY-MM-DD]]
+// Every scenario of the grid is simulated in its own child process, as many at a time as there
+// are cores, against the same pass bookings.
+void simulate(const char *args) {
+    SimAxis axes[SIM_MAX_AXES];
+    int axisCount = 0, scenarios = 1, offset = 0, length;
+    char option[20], list[100], window[64] = "";
+    while (sscanf(args + offset, " -%19s %99s%n", option, list, &length) == 2) {
+        offset += length;
+        if (axisCount == SIM_MAX_AXES) {
+            printf("At most %d capacities can be varied at once.\n", SIM_MAX_AXES);
+            return;
+        }
+        SimAxis *axis = &axes[axisCount++];
+        axis->target = strcmp(option, "bays") == 0 ? SIM_BAYS : strcmp(option, "stock") == 0 ? SIM_STOCK : getResourceIndex(option);
+        if (axis->target == -1) {
+            printf("Unknown capacity: %s (Expected: bays, stock or an essential)\n", option);
+            return;
+        }
+        axis->count = 0;
+        for (char *value = strtok(list, ","); value != NULL; value = strtok(NULL, ",")) {
+            char *end;
+            if (axis->count == SIM_MAX_VALUES) break;
+            axis->relative[axis->count] = value[0] == '+' || value[0] == '-';
+            axis->values[axis->count] = strtol(value, &end, 10);
+            if (*end != '\0' || end == value) {
+                printf("Invalid value for %s: %s\n", option, value);
+                return;
+            }
+            axis->count++;
+        }
+        scenarios *= axis->count;
+    }
+    sscanf(args + offset, " %63[^\n]", window);
+    if (axisCount == 0) {
+        printf("Usage: simulate -bays 10,20,+50 -stock 3,+2 [-<essential> 1,2] [YYYY-MM-DD [YYYY-MM-DD]]\n");
+        return;
+    }
+    if (scenarios > SIM_MAX_SCENARIOS) {
+        printf("Too many scenarios: %d (Maximum: %d)\n", scenarios, SIM_MAX_SCENARIOS);
+        return;
+    }
+    if (!beginPass(window)) return;
+
+    Site savedSites[MAX_SITES];
+    memcpy(savedSites, sites, sizeof(sites));
+    SimResult results[SIM_MAX_SCENARIOS];
+    char labels[SIM_MAX_SCENARIOS][128];
+    const char *errors[SIM_MAX_SCENARIOS];
+    int pipes[SIM_MAX_SCENARIOS][2];
+    pid_t pids[SIM_MAX_SCENARIOS];
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores < 1) cores = 1;
+    double start = nowMs();
+
+    fflush(stdout);
+    for (int first = 0; first < scenarios; first += cores) {
+        int last = first + cores < scenarios ? first + cores : scenarios;
+        for (int k = first; k < last; k++) {
+            pids[k] = -1;
+            errors[k] = applyScenario(axes, axisCount, k, labels[k], sizeof(labels[k]));
+            if (errors[k] == NULL) {
+                if (pipe(pipes[k]) == -1 || (pids[k] = fork()) < 0) {
+                    perror("Simulation fork failed");
+                    exit(1);
+                }
+                if (pids[k] == 0) {
+                    close(pipes[k][0]);
+                    freopen("/dev/null", "w", stdout); // suggestions are of no use here
+                    suggestionsEnabled = 0;
+                    simulateScenario(&results[k]);
+                    write(pipes[k][1], &results[k], sizeof(SimResult));
+                    exit(0);
+                }
+                close(pipes[k][1]);
             }
+            memcpy(sites, savedSites, sizeof(sites));
+        }
+        for (int k = first; k < last; k++) {
+            if (pids[k] == -1) continue;
+            if (!readAll(pipes[k][0], &results[k], sizeof(SimResult))) errors[k] = "simulation failed";
+            close(pipes[k][0]);
+            waitpid(pids[k], NULL, 0);
+        }
+    }
+
+    printf("\n*** Capacity Simulation (%d bookings, %d scenarios, %.0f ms) ***\n", totalBookings, scenarios, nowMs() - start);
+    printf("Accepted / bay utilization / essential utilization:\n");
+    printf("    %-32s %-22s %-22s %-22s\n", "Scenario", "FCFS", "PRIO", "OPTI");
+    for (int k = 0; k < scenarios; k++) {
+        printf("    %-32s", labels[k]);
+        for (int a = 0; a < 3; a++) {
+            char cell[32];
+            if (errors[k] != NULL) snprintf(cell, sizeof(cell), a == 0 ? "(%s)" : "", errors[k]);
+            else snprintf(cell, sizeof(cell), "%.1f / %.1f / %.1f%%", results[k].accepted[a], results[k].bayUse[a], results[k].essentialUse[a]);
+            printf(" %-22s", cell);
+        }
+        printf("\n");
+    }
+    endPass();
+}
+
+// Deterministic generator for the workload tool (splitmix64), so a seed gives the same file on
+// every platform, unlike rand().
+uint64_t nextRandom(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+double randomUnit(uint64_t *state) {
+    return (nextRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Index drawn from count weights in proportion to them.
+int randomWeighted(uint64_t *state, const double weights[], int count) {
+    double total = 0;
+    for (int i = 0; i < count; i++) total += weights[i];
+    double pick = randomUnit(state) * total;
+    for (int i = 0; i < count - 1; i++) {
+        if (pick < weights[i]) return i;
+        pick -= weights[i];
+    }
+    return count - 1;
+}
+
+// Parses "name:weight,name:weight,..." (a missing weight is 1). Returns the number of entries,
+// or -1 if there are too many or a weight is not a positive number.
+int parseWeights(char *list, char names[][20], double weights[], int max) {
+    int count = 0;
+    for (char *item = strtok(list, ","); item != NULL; item = strtok(NULL, ",")) {
+        if (count == max) return -1;
+        char *colon = strchr(item, ':');
+        weights[count] = 1;
+        if (colon != NULL) {
+            *colon = '\0';
+            weights[count] = atof(colon + 1);
         }
+        if (weights[count] <= 0) return -1;
+        snprintf(names[count], sizeof(names[count]), "%.19s", item);
+        count++;
     }
+    return count;
 }
 
-int compareBookings(const void *a, const void *b) {
-    Booking *bookingA = (Booking *)a;
-    Booking *bookingB = (Booking *)b;
-    return bookingA->priority - bookingB->priority;
-}
+// generateBatch -<file> <commands> <seed> [<option> <value> ...]
+// Writes an addBatch file of synthetic requests. Options (defaults in brackets):
+//   members 5 [5]                         start 2025-05-12 [2025-05-12]   days 14 [14]
+//   peaks 9,18 [9,13,18] spread 2 [2]     arrival hours cluster around the peaks
+//   durations 1:4,2:3,1.5:2 [1:4,2:3,3:2,4:1]   types parking:5,reservation:3,event:1,essentials:1
+//   essentials battery:3,locker:2,... [all 1]   extra 0.4 [0.4] chance of each further essential
+//   malformed 0.01 [0]                    share of lines with a bad member, date, time or essential
+const char* generateBatch(const char *args) {
+    static char error[64];
+    char file[64], option[20], value[200];
+    long commands;
+    unsigned long long seed;
+    int offset = 0, length;
+    if (sscanf(args, " -%63s %ld %llu%n", file, &commands, &seed, &length) != 3 || commands < 0) {
+        return "Usage: generateBatch -<file> <commands> <seed> [<option> <value> ...]";
+    }
+    offset = length;
+
+    int memberCount = 5, days = 14;
+    double spread = 2, extra = 0.4, malformed = 0;
+    char start[20] = "2025-05-12";
+    char peakList[200] = "9,13,18", durationList[200] = "1:4,2:3,3:2,4:1";
+    char typeList[200] = "parking:5,reservation:3,event:1,essentials:1", essentialList[200] = "";
+    for (int r = 0; r < essentialCount; r++) {
+        strcat(essentialList, r > 0 ? "," : "");
+        strcat(essentialList, resourceNames[r]);
+    }
+    while (sscanf(args + offset, " %19s %199s%n", option, value, &length) == 2) {
+        offset += length;
+        if (strcmp(option, "members") == 0) memberCount = atoi(value);
+        else if (strcmp(option, "start") == 0) snprintf(start, sizeof(start), "%.19s", value);
+        else if (strcmp(option, "days") == 0) days = atoi(value);
+        else if (strcmp(option, "peaks") == 0) strcpy(peakList, value);
+        else if (strcmp(option, "spread") == 0) spread = atof(value);
+        else if (strcmp(option, "durations") == 0) strcpy(durationList, value);
+        else if (strcmp(option, "types") == 0) strcpy(typeList, value);
+        else if (strcmp(option, "essentials") == 0) strcpy(essentialList, value);
+        else if (strcmp(option, "extra") == 0) extra = atof(value);
+        else if (strcmp(option, "malformed") == 0) malformed = atof(value);
+        else {
+            snprintf(error, sizeof(error), "Unknown generator option: %.19s", option);
+            return error;
+        }
+    }
+    if (memberCount < 1 || memberCount > 5) return "Invalid members (Expected: 1 to 5, the registered members)";
+    if (!isValidDate(start) || days < 1) return "Invalid start or days";
+    if (spread < 0 || extra < 0 || extra >= 1 || malformed < 0 || malformed > 1) return "Invalid spread, extra or malformed rate";
+
+    char peakNames[24][20], durationNames[16][20], typeNames[4][20], essentialNames[MAX_RESOURCES][20];
+    double peakWeights[24], durationWeights[16], typeWeights[4], essentialWeights[MAX_RESOURCES];
+    int peaks = parseWeights(peakList, peakNames, peakWeights, 24);
+    int durations = parseWeights(durationList, durationNames, durationWeights, 16);
+    int types = parseWeights(typeList, typeNames, typeWeights, 4);
+    int popular = parseWeights(essentialList, essentialNames, essentialWeights, MAX_RESOURCES);
+    if (peaks < 1 || durations < 1 || types < 1 || popular < 1) return "Invalid weight list (Expected: name:weight,...)";
+    const char *typeCommands[4];
+    for (int t = 0; t < types; t++) {
+        int priority = getBookingPriority(typeNames[t]);
+        if (priority == -1) return "Unknown type (Expected: parking, reservation, event or essentials)";
+        typeCommands[t] = priority == PRIORITY_EVENT ? "addEvent" : priority == PRIORITY_RESERVATION ? "addReservation" :
+                          priority == PRIORITY_PARKING ? "addParking" : "bookEssentials";
+    }
+    for (int e = 0; e < popular; e++) {
+        if (!isValidResource(essentialNames[e])) return "Unknown essential in essentials";
+    }
+
+    FILE *out = fopen(file, "w");
+    if (out == NULL) return "Cannot create batch file";
+    setvbuf(out, NULL, _IOFBF, 1 << 20);
+    uint64_t state = seed;
+    int firstDay = dateToDay(start);
+    long broken = 0;
+    double begin = nowMs();
+    for (long c = 0; c < commands; c++) {
+        int t = randomWeighted(&state, typeWeights, types);
+        char member[20], date[11], time[6], list[100] = "";
+        snprintf(member, sizeof(member), "member_%c", 'A' + (int)(nextRandom(&state) % memberCount));
+        dayToDate(firstDay + (int)(nextRandom(&state) % days), date);
+        if (!isValidDate(date)) date[9]--; // 29 February is not accepted, take the 28th
 
-int allocateResources(int startMinutes, int durationMinutes, char essentials[MAX_RESOURCES][20]) {
-    int resourceCount[MAX_RESOURCES] = {0};
-    for (int i = 0; i < MAX_RESOURCES; i++) {
-        if (strcmp(essentials[i], "battery") == 0) {
-            resourceCount[0]++;  // battery
-            resourceCount[1]++;  // cable (dependency)
-        } else if (strcmp(essentials[i], "cable") == 0) {
-            resourceCount[1]++;  // cable
-            resourceCount[0]++;  // battery (dependency)
-        } else if (strcmp(essentials[i], "locker") == 0) {
-            resourceCount[2]++;  // locker
-            resourceCount[3]++;  // umbrella (dependency)
-        } else if (strcmp(essentials[i], "umbrella") == 0) {
-            resourceCount[3]++;  // umbrella
-            resourceCount[2]++;  // locker (dependency)
-        } else if (strcmp(essentials[i], "inflation") == 0) {
-            resourceCount[4]++;  // inflation
-            resourceCount[5]++;  // valetpark (dependency)
-        } else if (strcmp(essentials[i], "valetpark") == 0) {
-            resourceCount[5]++;  // valetpark
-            resourceCount[4]++;  // inflation (dependency)
-        }
-    }
-
-    int startSlot = startMinutes / 60;
-    int endSlot = (startMinutes + durationMinutes) / 60 + ((startMinutes + durationMinutes) % 60 > 0 ? 1 : 0);
+        // Hour around a peak: Irwin-Hall approximation of a normal with the given spread.
+        double noise = randomUnit(&state) + randomUnit(&state) + randomUnit(&state) - 1.5;
+        int hour = atoi(peakNames[randomWeighted(&state, peakWeights, peaks)]) + (int)(noise * 2 * spread);
+        if (hour < 0) hour = 0;
+        if (hour > 23) hour = 23;
+        snprintf(time, sizeof(time), "%02d:%02d", hour, nextRandom(&state) % 2 ? 30 : 0);
+        double duration = atof(durationNames[randomWeighted(&state, durationWeights, durations)]);
 
-    for (int i = 0; i < MAX_RESOURCES; i++) {
-        if (resourceCount[i] > 0) {
-            for (int slot = startSlot; slot < endSlot; slot++) {
-                if (resourceCount[i] > resourceAvailability[slot][i]) {
-                    return 0;
-                }
-            }
+        int listed = 0, taken = 0;
+        // bookEssentials takes one essential; half the other bookings list one, then more at the extra rate.
+        int wanted = 0;
+        if (strcmp(typeCommands[t], "bookEssentials") == 0) wanted = 1;
+        else while (wanted < 3 && randomUnit(&state) < (wanted == 0 ? 0.5 : extra)) wanted++;
+        while (listed < wanted && listed < popular) {
+            int e = randomWeighted(&state, essentialWeights, popular);
+            if (taken & (1 << e)) continue;
+            taken |= 1 << e;
+            strcat(list, " ");
+            strcat(list, essentialNames[e]);
+            listed++;
         }
-    }
 
-    for (int i = 0; i < MAX_RESOURCES; i++) {
-        if (resourceCount[i] > 0) {
-            for (int slot = startSlot; slot < endSlot; slot++) {
-                resourceAvailability[slot][i] -= resourceCount[i];
+        if (randomUnit(&state) < malformed) {
+            broken++;
+            switch (nextRandom(&state) % 4) {
+                case 0: strcpy(member, "member_Z"); break;
+                case 1: strcpy(date, "2025-13-40"); break;
+                case 2: strcpy(time, "25:61"); break;
+                default: strcpy(list, " teleporter"); break;
             }
         }
+        fprintf(out, "%s -%s %s %s %.1f%s\n", typeCommands[t], member, date, time, duration, list);
     }
-    return 1;
+    fclose(out);
+    printf("Wrote %ld command(s) (%ld malformed) to %s in %.0f ms.\n", commands, broken, file, nowMs() - begin);
+    return NULL;
 }
 
-void releaseResources(int startMinutes, int durationMinutes, char essentials[MAX_RESOURCES][20]) {
-    int resourceCount[MAX_RESOURCES] = {0};
-    for (int i = 0; i < MAX_RESOURCES; i++) {
-        if (strcmp(essentials[i], "battery") == 0) {
-            resourceCount[0]++;  // battery
-            resourceCount[1]++;  // cable (dependency)
-        } else if (strcmp(essentials[i], "cable") == 0) {
-            resourceCount[1]++;  // cable
-            resourceCount[0]++;  // battery (dependency)
-        } else if (strcmp(essentials[i], "locker") == 0) {
-            resourceCount[2]++;  // locker
-            resourceCount[3]++;  // umbrella (dependency)
-        } else if (strcmp(essentials[i], "umbrella") == 0) {
-            resourceCount[3]++;  // umbrella
-            resourceCount[2]++;  // locker (dependency)
-        } else if (strcmp(essentials[i], "inflation") == 0) {
-            resourceCount[4]++;  // inflation
-            resourceCount[5]++;  // valetpark (dependency)
-        } else if (strcmp(essentials[i], "valetpark") == 0) {
-            resourceCount[5]++;  // valetpark
-            resourceCount[4]++;  // inflation (dependency)
-        }
-    }
-
-    int startSlot = startMinutes / 60;
-    int endSlot = (startMinutes + durationMinutes) / 60 + ((startMinutes + durationMinutes) % 60 > 0 ? 1 : 0);
+// Operations timed by benchmarkSuite, each on the real code path but in-process (no site forks),
+// except the summary report, which is measured as it runs.
+#define SUITE_OPERATIONS 7
+const char *suiteOperations[SUITE_OPERATIONS] = {
+    "ingest", "fcfs", "priority", "optimized", "suggestions", "printBookings", "summaryReport"
+};
 
-    for (int i = 0; i < MAX_RESOURCES; i++) {
-        if (resourceCount[i] > 0) {
-            for (int slot = startSlot; slot < endSlot; slot++) {
-                resourceAvailability[slot][i] += resourceCount[i];
-            }
-        }
-    }
+int compareDoubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
 }
 
-char* calculateEndTime(const char* startTime, float duration) {
-    int startHour, startMin;
-    sscanf(startTime, "%d:%d", &startHour, &startMin);
-    int totalMin = startHour * 60 + startMin + (int)(duration * 60);
-    int endHour = totalMin / 60 % 24;
-    int endMin = totalMin % 60;
-    char* endTime = (char*)malloc(6 * sizeof(char));
-    sprintf(endTime, "%02d:%02d", endHour, endMin);
-    return endTime;
+// Nearest-rank percentile of sorted samples.
+double percentile(const double sorted[], int count, double p) {
+    int rank = (int)(p / 100 * count + 0.999999);
+    if (rank < 1) rank = 1;
+    return sorted[rank - 1];
 }
 
-const char* getBookingType(int priority) {
-    switch (priority) {
-        case PRIORITY_EVENT: return "Event";
-        case PRIORITY_RESERVATION: return "Reservation";
-        case PRIORITY_PARKING: return "Parking";
-        case PRIORITY_ESSENTIAL: return "Essentials";
-        default: return "Unknown";
-    }
+// Sends stdout to /dev/null; returns the descriptor that restoreOutput puts back.
+int muteOutput() {
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    int null = open("/dev/null", O_WRONLY);
+    dup2(null, STDOUT_FILENO);
+    close(null);
+    return saved;
 }
 
-void printBookings(const char *algorithm) {
-    printf("\n*** Booking Schedule (%s) ***\n", algorithm);
+void restoreOutput(int saved) {
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+}
 
-    char members[5][20] = {"member_A", "member_B", "member_C", "member_D", "member_E"};
+// Forgets every booking and empties the calendars, as at startup.
+void clearBookings() {
+    totalBookings = passBaseBookings = 0;
+    totalRules = liveOccurrenceCount = liveCutoffDay = 0;
+    waitCount = waitLongest = 0;
+    for (int s = 0; s < siteCount; s++) {
+        liveCalendars[s].site = s;
+        useCalendar(&liveCalendars[s]);
+        resetAvailability();
+    }
+    useCalendar(&passCalendar);
+    resetAvailability();
+}
 
-    printf("\n*** ACCEPTED Bookings ***\n");
-    for (int m = 0; m < 5; m++) {
-        char *member = members[m];
-        int hasBookings = 0;
-        for (int i = 0; i < totalBookings; i++) {
-            Booking *b = &bookings[i];
-            if (strcmp(b->memberName, member) == 0 && b->accepted) {
-                if (!hasBookings) {
-                    printf("%s has the following bookings:\n", member);
-                    printf("%-12s %-6s %-6s %-12s %-20s\n", "Date", "Start", "End", "Type", "Device");
-                    printf("===============================================================\n");
-                    hasBookings = 1;
-                }
-                char *endTime = calculateEndTime(b->time, b->duration);
-                char devices[100] = "";
-                for (int j = 0; j < MAX_RESOURCES; j++) {
-                    if (strlen(b->essentials[j]) > 0) {
-                        strcat(devices, b->essentials[j]);
-                        strcat(devices, ", ");
-                    }
-                }
-                if (strlen(devices) > 0) devices[strlen(devices) - 2] = '\0';
-                else strcpy(devices, "*");
-                printf("%-12s %-6s %-6s %-12s %-20s\n", b->date, b->time, endTime, getBookingType(b->priority), devices);
-                free(endTime);
-            }
+// benchmarkSuite [counts 10,25,50,100] [repeats 5] [seed 1] [json benchmark.json]
+// For every booking count, generates a one-day batch (see generateBatch) and times each operation over
+// the repeats. Prints a table and writes throughput, latency percentiles and peak RSS as JSON.
+// Runs in a child process so the bookings already loaded are left alone.
+void benchmarkSuite(const char *args) {
+    char counts[100] = "10,25,50,100", json[64] = "benchmark.json", option[20], value[100];
+    int repeats = 5, offset = 0, length;
+    unsigned long long seed = 1;
+    while (sscanf(args + offset, " %19s %99s%n", option, value, &length) == 2) {
+        offset += length;
+        if (strcmp(option, "counts") == 0) strcpy(counts, value);
+        else if (strcmp(option, "repeats") == 0) repeats = atoi(value);
+        else if (strcmp(option, "seed") == 0) seed = strtoull(value, NULL, 10);
+        else if (strcmp(option, "json") == 0) snprintf(json, sizeof(json), "%.63s", value);
+        else {
+            printf("Usage: benchmarkSuite [counts 10,25,50,100] [repeats 5] [seed 1] [json benchmark.json]\n");
+            return;
         }
-        if (hasBookings) printf("\n");
     }
-    printf("- End -\n");
+    if (repeats < 1 || repeats > 1000) {
+        printf("Invalid repeats (Expected: 1 to 1000)\n");
+        return;
+    }
+    int sizes[16], sizeCount = 0; // parsed up front: generateBatch uses strtok too
+    for (char *item = strtok(counts, ","); item != NULL && sizeCount < 16; item = strtok(NULL, ",")) {
+        sizes[sizeCount] = atoi(item);
+        if (sizes[sizeCount] < 1 || sizes[sizeCount] > maxBookings) {
+            printf("Invalid booking count: %s (Expected: 1 to %d)\n", item, maxBookings);
+            return;
+        }
+        sizeCount++;
+    }
 
-    printf("\n*** Parking Booking - REJECTED / %s ***\n", algorithm);
-    for (int m = 0; m < 5; m++) {
-        char *member = members[m];
-        int rejectedCount = 0;
-        for (int i = 0; i < totalBookings; i++) {
-            if (strcmp(bookings[i].memberName, member) == 0 && !bookings[i].accepted) {
-                rejectedCount++;
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("Fork failed");
+        return;
+    }
+    if (pid > 0) {
+        waitpid(pid, NULL, 0);
+        return;
+    }
+
+    FILE *out = fopen(json, "w");
+    if (out == NULL) {
+        printf("Cannot create %s\n", json);
+        exit(1);
+    }
+    setvbuf(out, NULL, _IONBF, 0); // the site children would flush a buffered copy again on exit
+    int capacity = repeats * MAX_PASS_BOOKINGS;
+    double *samples[SUITE_OPERATIONS];
+    for (int o = 0; o < SUITE_OPERATIONS; o++) samples[o] = malloc(capacity * sizeof(double));
+    void (*schedulers[3])() = {processBookings_FCFS, processBookings_Priority, processBookings_Optimized};
+    char batch[64];
+    snprintf(batch, sizeof(batch), "/tmp/spms_bench_%d.dat", (int)getpid());
+
+    printf("\n*** Benchmark Suite (seed %llu, %d repeat(s), results in %s) ***\n", seed, repeats, json);
+    printf("%-9s %-14s %-8s %-10s %-10s %-10s %-10s %-12s\n", "Bookings", "Operation", "Samples", "p50 ms", "p90 ms", "p99 ms", "max ms", "per second");
+    printf("==========================================================================================\n");
+    fprintf(out, "{\n  \"seed\": %llu,\n  \"repeats\": %d,\n  \"runs\": [", seed, repeats);
+    for (int size = 0; size < sizeCount; size++) {
+        int n = sizes[size];
+        char generate[160];
+        snprintf(generate, sizeof(generate), " -%s %d %llu days 1", batch, n, seed); // one busy day
+        int counted[SUITE_OPERATIONS] = {0};
+        double perItem[SUITE_OPERATIONS] = {0}; // bookings (or suggestion calls) per sample
+
+        int saved = muteOutput();
+        generateBatch(generate);
+        for (int r = 0; r < repeats; r++) {
+            double start;
+            clearBookings();
+            start = nowMs();
+            addBatch(batch);
+            samples[0][counted[0]++] = nowMs() - start;
+            perItem[0] = totalBookings;
+            if (!beginPass("")) continue;
+
+            for (int a = 0; a < 3; a++) {
+                memcpy(bookings, initialBookings, sizeof(bookings));
+                resetAvailability();
+                suggestionsEnabled = 0;
+                start = nowMs();
+                schedulers[a]();
+                samples[1 + a][counted[1 + a]++] = nowMs() - start;
+                perItem[1 + a] = totalBookings;
+                suggestionsEnabled = 1;
+                if (a != 0) continue;
+
+                // Suggestions for what FCFS rejected, and printing its schedule.
+                for (int i = 0; i < totalBookings; i++) {
+                    if (bookings[i].accepted) continue;
+                    start = nowMs();
+                    suggestAlternativeSlots(&bookings[i]);
+                    samples[4][counted[4]++] = nowMs() - start;
+                }
+                perItem[4] = 1;
+                start = nowMs();
+                printBookings("FCFS");
+                samples[5][counted[5]++] = nowMs() - start;
+                perItem[5] = totalBookings;
             }
+            memcpy(bookings, initialBookings, sizeof(bookings));
+            start = nowMs();
+            generateSummaryReport();
+            samples[6][counted[6]++] = nowMs() - start;
+            perItem[6] = totalBookings;
+            endPass();
         }
-        if (rejectedCount > 0) {
-            printf("%s (there are %d bookings rejected):\n", member, rejectedCount);
-            printf("%-12s %-6s %-6s %-12s %-20s %-30s\n", "Date", "Start", "End", "Type", "Essentials", "Reason");
-            printf("================================================================================\n");
-            for (int i = 0; i < totalBookings; i++) {
-                Booking *b = &bookings[i];
-                if (strcmp(b->memberName, member) == 0 && !b->accepted) {
-                    char *endTime = calculateEndTime(b->time, b->duration);
-                    char essentials[100] = "";
-                    for (int j = 0; j < MAX_RESOURCES; j++) {
-                        if (strlen(b->essentials[j]) > 0) {
-                            strcat(essentials, b->essentials[j]);
-                            strcat(essentials, ", ");
-                        }
-                    }
-                    if (strlen(essentials) > 0) essentials[strlen(essentials) - 2] = '\0';
-                    else strcpy(essentials, "-");
-                    printf("%-12s %-6s %-6s %-12s %-20s %-30s\n", b->date, b->time, endTime,
-                           getBookingType(b->priority), essentials, b->reasonForRejection);
-                    free(endTime);
-                }
+        restoreOutput(saved);
+        remove(batch);
+
+        fprintf(out, "%s\n    {\n      \"bookings\": %d,\n      \"operations\": [", size > 0 ? "," : "", n);
+        for (int o = 0; o < SUITE_OPERATIONS; o++) {
+            double total = 0, p50 = 0, p90 = 0, p99 = 0, max = 0, perSecond = 0;
+            qsort(samples[o], counted[o], sizeof(double), compareDoubles);
+            for (int k = 0; k < counted[o]; k++) total += samples[o][k];
+            if (counted[o] > 0) {
+                p50 = percentile(samples[o], counted[o], 50);
+                p90 = percentile(samples[o], counted[o], 90);
+                p99 = percentile(samples[o], counted[o], 99);
+                max = samples[o][counted[o] - 1];
+                if (total > 0) perSecond = perItem[o] * counted[o] / (total / 1000);
             }
-            printf("\n");
+            printf("%-9d %-14s %-8d %-10.3f %-10.3f %-10.3f %-10.3f %-12.0f\n", n, suiteOperations[o], counted[o], p50, p90, p99, max, perSecond);
+            fprintf(out, "%s\n        {\"name\": \"%s\", \"samples\": %d, \"meanMs\": %.4f, \"p50Ms\": %.4f, \"p90Ms\": %.4f, "
+                    "\"p99Ms\": %.4f, \"maxMs\": %.4f, \"perSecond\": %.1f}", o > 0 ? "," : "", suiteOperations[o], counted[o],
+                    counted[o] > 0 ? total / counted[o] : 0, p50, p90, p99, max, perSecond);
         }
+        fprintf(out, "\n      ]\n    }");
     }
-    printf("- End -\n");
+
+    struct rusage self, children;
+    getrusage(RUSAGE_SELF, &self);
+    getrusage(RUSAGE_CHILDREN, &children);
+    printf("Peak RSS: %ld KB (site and report children: %ld KB)\n", self.ru_maxrss, children.ru_maxrss);
+    fprintf(out, "\n  ],\n  \"peakRssKb\": %ld,\n  \"childPeakRssKb\": %ld\n}\n", self.ru_maxrss, children.ru_maxrss);
+    fclose(out);
+    fflush(stdout);
+    exit(0);
 }
 
-void generateSummaryReport() {
-    Booking originalBookings[MAX_BOOKINGS];
-    int originalParking[TIME_SLOTS][PARKING_SLOTS];
-    int originalResources[TIME_SLOTS][MAX_RESOURCES];
-    
-    // Save the original state of bookings
-    memcpy(originalBookings, initialBookings, sizeof(bookings));
-    memcpy(originalParking, parkingAvailability, sizeof(parkingAvailability));
-    memcpy(originalResources, resourceAvailability, sizeof(resourceAvailability));
+// First field that differs between two schedules of the same bookings, or NULL if they agree.
+const char* compareSchedules(const Booking *reference, const Booking *candidate, int count, int *index) {
+    for (*index = 0; *index < count; (*index)++) {
+        const Booking *a = &reference[*index], *b = &candidate[*index];
+        if (strcmp(a->memberName, b->memberName) != 0 || strcmp(a->date, b->date) != 0) return "order";
+        if (a->accepted != b->accepted) return "acceptance";
+        if (strcmp(a->time, b->time) != 0 || a->duration != b->duration) return "time";
+        if (a->accepted && a->parkingSlot != b->parkingSlot) return "bay";
+        if (a->assignedSite != b->assignedSite) return "site";
+        if (!a->accepted && a->reason != b->reason) return "reason";
+    }
+    return NULL;
+}
 
-    int fcfsAccepted = 0, prioAccepted = 0, optiAccepted = 0;
-    float fcfsResourceUsage[MAX_RESOURCES] = {0};
-    float prioResourceUsage[MAX_RESOURCES] = {0};
-    float optiResourceUsage[MAX_RESOURCES] = {0};
+// fuzzEngines [rounds 200] [seed 1] [bookings 40]
+// Schedules random booking sets with the reference path (generic per-cell scans, in process) and
+// with each faster engine, and compares every booking's acceptance, time, bay, site and reason.
+// Rounds mix edge times, bookings running past midnight, stock that is fully taken, and crowded
+// hours that set off displacement chains, under random capacities, slot lengths and policies.
+// A round that disagrees is kept as fuzz_<seed>_<round>.dat. Runs in a child process.
+#define FUZZ_ENGINES 2
+#define FUZZ_REPORTED 5 // mismatches printed in full
 
-    // Reset availability to initial state (all parking slots available, resources at full stock)
-    int initialParking[TIME_SLOTS][PARKING_SLOTS];
-    int initialResources[TIME_SLOTS][MAX_RESOURCES];
-    memset(initialParking, 1, sizeof(initialParking)); // 1 means available
-    for (int i = 0; i < TIME_SLOTS; i++) {
-        for (int j = 0; j < MAX_RESOURCES; j++) {
-            initialResources[i][j] = RESOURCE_STOCK;
+void fuzzEngines(const char *args) {
+    static Booking reference[MAX_PASS_BOOKINGS], candidate[MAX_PASS_BOOKINGS];
+    char option[20], value[20];
+    int rounds = 200, maxCount = 40, offset = 0, length;
+    unsigned long long seed = 1;
+    while (sscanf(args + offset, " %19s %19s%n", option, value, &length) == 2) {
+        offset += length;
+        if (strcmp(option, "rounds") == 0) rounds = atoi(value);
+        else if (strcmp(option, "seed") == 0) seed = strtoull(value, NULL, 10);
+        else if (strcmp(option, "bookings") == 0) maxCount = atoi(value);
+        else {
+            printf("Usage: fuzzEngines [rounds 200] [seed 1] [bookings 40]\n");
+            return;
         }
     }
+    if (rounds < 1 || maxCount < 1 || maxCount > maxBookings) {
+        printf("Invalid rounds or bookings (Expected: rounds >= 1, bookings 1 to %d)\n", maxBookings);
+        return;
+    }
 
-    // FCFS Evaluation
-    memcpy(bookings, originalBookings, sizeof(bookings));
-    memcpy(parkingAvailability, initialParking, sizeof(initialParking));
-    memcpy(resourceAvailability, initialResources, sizeof(initialResources));
-    processBookings_FCFS();
-    for (int i = 0; i < totalBookings; i++) {
-        if (bookings[i].accepted) {
-            fcfsAccepted++;
-            int slots = (int)bookings[i].duration;
-            for (int j = 0; j < MAX_RESOURCES; j++) {
-                if (contains(bookings[i].essentials, resourceNames[j]) != -1) {
-                    fcfsResourceUsage[j] += slots;
-                }
-            }
-        }
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("Fork failed");
+        return;
+    }
+    if (pid > 0) {
+        waitpid(pid, NULL, 0);
+        return;
     }
 
-    // Priority Evaluation
-    memcpy(bookings, originalBookings, sizeof(bookings));
-    memcpy(parkingAvailability, initialParking, sizeof(initialParking));
-    memcpy(resourceAvailability, initialResources, sizeof(initialResources));
-    processBookings_Priority();
-    for (int i = 0; i < totalBookings; i++) {
-        if (bookings[i].accepted) {
-            prioAccepted++;
-            int slots = (int)bookings[i].duration;
-            for (int j = 0; j < MAX_RESOURCES; j++) {
-                if (contains(bookings[i].essentials, resourceNames[j]) != -1) {
-                    prioResourceUsage[j] += slots;
-                }
+    const char *engines[FUZZ_ENGINES] = {"fast paths", "site processes"};
+    const char *types[4] = {"addEvent", "addReservation", "addParking", "bookEssentials"};
+    const char *durations[8] = {"0.1", "0.5", "1.0", "2.0", "3.0", "6.0", "23.9", "24.0"};
+    int slotChoices[3] = {60, 30, 15}, bayChoices[6] = {1, 2, 3, 5, 10, FAST_BAYS};
+    void (*schedulers[2])() = {processBookings_FCFS, processBookings_Priority};
+    int passes[FUZZ_ENGINES][2] = {{0}}, mismatches[FUZZ_ENGINES][2] = {{0}}, reported = 0;
+    uint64_t state = seed;
+    char batch[64];
+    snprintf(batch, sizeof(batch), "/tmp/spms_fuzz_%d.dat", (int)getpid());
+    suggestionsEnabled = 1;
+
+    printf("\n*** Engine Fuzzing (seed %llu, %d round(s) of up to %d bookings) ***\n", seed, rounds, maxCount);
+    for (int round = 1; round <= rounds; round++) {
+        // Capacities and policies first: they decide how the bookings are read in.
+        slotMinutes = slotChoices[nextRandom(&state) % 3];
+        timeSlots = MINUTES_PER_DAY / slotMinutes;
+        sites[0].bays = bayChoices[nextRandom(&state) % 6];
+        int scarce = nextRandom(&state) % 2; // half the rounds have 0 or 1 of every essential
+        for (int r = 0; r < essentialCount; r++) {
+            sites[0].stock[r] = nextRandom(&state) % (scarce ? 2 : MAX_STOCK + 1);
+        }
+        preemptionMode = nextRandom(&state) % 2 ? PREEMPT_CASCADE : PREEMPT_LEGACY;
+        bayPolicy = nextRandom(&state) % BAY_POLICY_COUNT;
+
+        FILE *file = fopen(batch, "w");
+        if (file == NULL) {
+            printf("Cannot create %s\n", batch);
+            exit(1);
+        }
+        int count = 1 + nextRandom(&state) % maxCount;
+        int crowdedHour = nextRandom(&state) % 24; // many requests start here
+        for (int i = 0; i < count; i++) {
+            int hour, minute = 0, kind = nextRandom(&state) % 10;
+            if (kind < 2) hour = 0;                              // start of day
+            else if (kind < 4) hour = 23, minute = nextRandom(&state) % 2 ? 0 : 59; // runs past midnight
+            else if (kind < 7) hour = crowdedHour;
+            else hour = nextRandom(&state) % 24, minute = nextRandom(&state) % 4 * 15;
+            int type = nextRandom(&state) % 4;
+            fprintf(file, "%s -%s 2025-05-%02d %02d:%02d %s", types[type], members[nextRandom(&state) % 5],
+                    12 + (int)(nextRandom(&state) % 2), hour, minute, durations[nextRandom(&state) % 8]);
+            int wanted = type == 3 ? 1 : nextRandom(&state) % 3;
+            for (int e = 0; e < wanted && essentialCount > 0; e++) {
+                fprintf(file, " %s", resourceNames[nextRandom(&state) % essentialCount]);
             }
+            fprintf(file, "\n");
         }
-    }
+        fclose(file);
 
-    // Optimized Evaluation
-    memcpy(bookings, originalBookings, sizeof(bookings));
-    memcpy(parkingAvailability, initialParking, sizeof(initialParking));
-    memcpy(resourceAvailability, initialResources, sizeof(initialResources));
-    processBookings_Optimized();
-    for (int i = 0; i < totalBookings; i++) {
-        if (bookings[i].accepted) {
-            optiAccepted++;
-            int slots = (int)bookings[i].duration;
-            for (int j = 0; j < MAX_RESOURCES; j++) {
-                if (contains(bookings[i].essentials, resourceNames[j]) != -1) {
-                    optiResourceUsage[j] += slots;
+        int saved = muteOutput();
+        clearBookings();
+        addBatch(batch);
+        int ready = beginPass("");
+        restoreOutput(saved);
+        if (!ready) continue;
+
+        int kept = 0;
+        for (int a = 0; a < 2; a++) {
+            fastPathsEnabled = 0;
+            memcpy(bookings, initialBookings, sizeof(bookings));
+            saved = muteOutput();
+            resetAvailability();
+            schedulers[a]();
+            restoreOutput(saved);
+            for (int i = 0; i < totalBookings; i++) reference[i] = bookings[passOrder[i]];
+
+            for (int e = 0; e < FUZZ_ENGINES; e++) {
+                fastPathsEnabled = 1;
+                memcpy(bookings, initialBookings, sizeof(bookings));
+                saved = muteOutput();
+                if (e == 0) {
+                    resetAvailability();
+                    schedulers[a]();
+                    for (int i = 0; i < totalBookings; i++) candidate[i] = bookings[passOrder[i]];
+                } else {
+                    scheduleSites(schedulers[a], NULL); // already gathered in pass order
+                    memcpy(candidate, bookings, sizeof(candidate));
                 }
+                restoreOutput(saved);
+
+                int index;
+                const char *field = compareSchedules(reference, candidate, totalBookings, &index);
+                passes[e][a]++;
+                if (field == NULL) continue;
+                mismatches[e][a]++;
+                if (!kept) {
+                    char keep[64];
+                    snprintf(keep, sizeof(keep), "fuzz_%llu_%d.dat", seed, round);
+                    rename(batch, keep);
+                    kept = 1;
+                }
+                if (reported++ >= FUZZ_REPORTED) continue;
+                Booking *r = &reference[index], *c = &candidate[index];
+                printf("Round %d (fuzz_%llu_%d.dat, %d-minute slots, %d bays, %s preemption, %s bays): %s with %s differs "
+                       "in %s at booking %d, %s %s %s:\n", round, seed, round, slotMinutes, sites[0].bays,
+                       preemptionMode == PREEMPT_LEGACY ? "legacy" : "cascade", getBayPolicyName(bayPolicy),
+                       schedulerName(schedulers[a]), engines[e], field, index + 1, r->memberName, r->date, r->time);
+                printf("    reference: %s %s bay %d site %d %s\n", r->accepted ? "accepted" : "rejected", r->time,
+                       r->parkingSlot, r->assignedSite, r->accepted ? "" : getReasonText(r->reason));
+                printf("    %-9s: %s %s bay %d site %d %s\n", e == 0 ? "fast" : "sites", c->accepted ? "accepted" : "rejected",
+                       c->time, c->parkingSlot, c->assignedSite, c->accepted ? "" : getReasonText(c->reason));
             }
         }
+        endPass();
     }
+    remove(batch);
 
-    // Calculate utilization for each algorithm
-    float totalSlots = TIME_SLOTS * PARKING_SLOTS * 7; // Assuming 7 days for simplicity
-    float fcfsUtilization[MAX_RESOURCES];
-    float prioUtilization[MAX_RESOURCES];
-    float optiUtilization[MAX_RESOURCES];
-    for (int i = 0; i < MAX_RESOURCES; i++) {
-        fcfsUtilization[i] = (fcfsResourceUsage[i] / (totalSlots * RESOURCE_STOCK)) * 100;
-        prioUtilization[i] = (prioResourceUsage[i] / (totalSlots * RESOURCE_STOCK)) * 100;
-        optiUtilization[i] = (optiResourceUsage[i] / (totalSlots * RESOURCE_STOCK)) * 100;
+    int failed = 0;
+    printf("%-16s %-10s %-8s %-10s\n", "Engine", "Scheduler", "Passes", "Mismatches");
+    printf("================================================\n");
+    for (int e = 0; e < FUZZ_ENGINES; e++) {
+        for (int a = 0; a < 2; a++) {
+            printf("%-16s %-10s %-8d %-10d\n", engines[e], schedulerName(schedulers[a]), passes[e][a], mismatches[e][a]);
+            failed += mismatches[e][a];
+        }
     }
+    printf(failed == 0 ? "All engines agree with the reference.\n" : "%d pass(es) disagree with the reference.\n", failed);
+    fflush(stdout);
+    exit(0);
+}
 
-    // Print the report
-    printf("\n*** Parking Booking Manager - Summary Report ***\n");
-    printf("Performance:\n");
-    printf("For FCFS:\n");
-    printf("    Total Number of Bookings Received: %d (100%%)\n", totalBookings);
-    printf("    Number of Bookings Assigned: %d (%.1f%%)\n", fcfsAccepted, (float)fcfsAccepted / totalBookings * 100);
-    printf("    Number of Bookings Rejected: %d (%.1f%%)\n", totalBookings - fcfsAccepted, (float)(totalBookings - fcfsAccepted) / totalBookings * 100);
-    printf("    Utilization of Time slot:\n");
-    for (int i = 0; i < MAX_RESOURCES; i++) {
-        printf("    %s - %.1f%%\n", resourceNames[i], fcfsUtilization[i]);
+// checkGolden [dir Outputs]
+// Replays every golden report <dir>/SPMS_Report<N>_G59.txt: loads Test_data<N>_G59.dat, prints
+// the schedule of the algorithm named in the report's first line and compares the two, ignoring
+// trailing blanks and empty lines. A report whose schedule changed on purpose keeps its file and
+// gets a SPMS_Report<N>_G59_v<k>.txt next to it. The older file is then replayed with the legacy
+// engine of its algorithm, or skipped if there is none. Runs in a child process.
+#define GOLDEN_LINES 512
+
+int compareLines(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// Non-empty lines of a report from its schedule header on (the suggestions printed while
+// scheduling come before it), trailing blanks removed. Each line is keyed by the block and the
+// member section it sits in, since booking rows carry neither, and the keys are sorted. Returns
+// the count, or -1 (with nothing kept) if the report has more than max lines.
+int readReportLines(FILE *file, char *lines[], int max) {
+    char line[256], block[256] = "", member[256] = "", key[800];
+    int count = 0, started = 0;
+    while (fgets(line, sizeof(line), file)) {
+        int end = strlen(line);
+        while (end > 0 && (line[end - 1] == '\n' || line[end - 1] == '\r' || line[end - 1] == ' ')) end--;
+        line[end] = 0;
+        if (strstr(line, "*** Booking Schedule") == line) started = 1;
+        if (!started || end == 0) continue;
+        if (count == max) {
+            while (count > 0) free(lines[--count]);
+            return -1;
+        }
+        if (strncmp(line, "***", 3) == 0) {
+            strcpy(block, line);
+            member[0] = 0;
+        } else if (strcmp(line, "- End -") == 0) {
+            member[0] = 0;
+        } else if ((line[0] < '0' || line[0] > '9') && line[0] != '=' && strncmp(line, "Date ", 5) != 0) {
+            strcpy(member, line); // "<member> has the following bookings:" or "<member> (there are ...)"
+        }
+        snprintf(key, sizeof(key), "%s | %s | %s", block, member, line);
+        lines[count++] = strdup(key);
     }
-    printf("    Invalid request(s) made: 0\n");
+    qsort(lines, count, sizeof(char *), compareLines);
+    return count;
+}
 
-    printf("For PRIO:\n");
-    printf("    Total Number of Bookings Received: %d (100%%)\n", totalBookings);
-    printf("    Number of Bookings Assigned: %d (%.1f%%)\n", prioAccepted, (float)prioAccepted / totalBookings * 100);
-    printf("    Number of Bookings Rejected: %d (%.1f%%)\n", totalBookings - prioAccepted, (float)(totalBookings - prioAccepted) / totalBookings * 100);
-    printf("    Utilization of Time slot:\n");
-    for (int i = 0; i < MAX_RESOURCES; i++) {
-        printf("    %s - %.1f%%\n", resourceNames[i], prioUtilization[i]);
+// Version of a golden report file name: 1 for SPMS_Report<N>_G59.txt, k for ..._G59_v<k>.txt,
+// 0 if it is not one. The <N> part is copied to id.
+int goldenVersion(const char *name, char *id, int size) {
+    const char *suffix = strstr(name, "_G59");
+    int version = 1;
+    char rest[8] = "";
+    if (strncmp(name, "SPMS_Report", 11) != 0 || suffix == NULL || suffix == name + 11 || suffix - name - 11 >= size) return 0;
+    if (strcmp(suffix, "_G59.txt") != 0 &&
+        (sscanf(suffix, "_G59_v%d%7s", &version, rest) != 2 || strcmp(rest, ".txt") != 0 || version < 2)) return 0;
+    snprintf(id, size, "%.*s", (int)(suffix - name - 11), name + 11);
+    return version;
+}
+
+void checkGolden(const char *args) {
+    char dir[64] = "Outputs";
+    sscanf(args, " dir %63s", dir);
+    DIR *folder = opendir(dir);
+    if (folder == NULL) {
+        printf("Cannot open golden directory: %s\n", dir);
+        return;
     }
-    printf("    Invalid request(s) made: 0\n");
 
-    printf("For OPTI:\n");
-    printf("    Total Number of Bookings Received: %d (100%%)\n", totalBookings);
-    printf("    Number of Bookings Assigned: %d (%.1f%%)\n", optiAccepted, (float)optiAccepted / totalBookings * 100);
-    printf("    Number of Bookings Rejected: %d (%.1f%%)\n", totalBookings - optiAccepted, (float)(totalBookings - optiAccepted) / totalBookings * 100);
-    printf("    Utilization of Time slot:\n");
-    for (int i = 0; i < MAX_RESOURCES; i++) {
-        printf("    %s - %.1f%%\n", resourceNames[i], optiUtilization[i]);
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("Fork failed");
+        closedir(folder);
+        return;
+    }
+    if (pid > 0) {
+        closedir(folder);
+        waitpid(pid, NULL, 0);
+        return;
     }
-    printf("    Invalid request(s) made: 0\n");
 
-    // Restore original state
-    memcpy(bookings, originalBookings, sizeof(bookings));
-    memcpy(parkingAvailability, originalParking, sizeof(parkingAvailability));
-    memcpy(resourceAvailability, originalResources, sizeof(resourceAvailability));
+    const char *names[3] = {"FCFS", "PRIORITY", "OPTIMIZED"};
+    void (*schedulers[3])() = {processBookings_FCFS, processBookings_Priority, processBookings_Optimized};
+    // What replays a report that a newer version replaced, per algorithm. NULL: nothing does.
+    const char *legacyNames[3] = {NULL, NULL, "LEGACY"};
+    void (*legacySchedulers[3])() = {NULL, NULL, processBookings_OptimizedLegacy};
+    int checked = 0, failed = 0;
+    struct dirent *entry;
+    printf("\n*** Golden Reports (%s) ***\n", dir);
+    while ((entry = readdir(folder)) != NULL) {
+        char id[32], path[320], newer[320], batch[64], algorithm[20] = "", line[256] = "";
+        int version = goldenVersion(entry->d_name, id, sizeof(id));
+        if (version == 0) continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        FILE *golden = fopen(path, "r");
+        if (golden == NULL) continue;
+        snprintf(batch, sizeof(batch), "Test_data%s_G59.dat", id);
+        fgets(line, sizeof(line), golden);
+        sscanf(line, "*** Booking Schedule (%19[^)])", algorithm);
+        int a = 0;
+        while (a < 3 && strcmp(names[a], algorithm) != 0) a++;
+        if (a == 3) {
+            printf("%-28s skipped (no schedule header)\n", entry->d_name);
+            fclose(golden);
+            continue;
+        }
+        snprintf(newer, sizeof(newer), "%s/SPMS_Report%s_G59_v%d.txt", dir, id, version + 1);
+        const char *engine = names[a];
+        void (*scheduler)() = schedulers[a];
+        if (access(newer, F_OK) == 0) {
+            if (legacySchedulers[a] == NULL) {
+                printf("%-28s %-10s skipped (replaced by %s)\n", entry->d_name, names[a], newer + strlen(dir) + 1);
+                fclose(golden);
+                continue;
+            }
+            engine = legacyNames[a];
+            scheduler = legacySchedulers[a];
+        }
+
+        FILE *actual = tmpfile();
+        int saved = muteOutput();
+        clearBookings();
+        addBatch(batch);
+        int ready = beginPass("");
+        fflush(stdout);
+        dup2(fileno(actual), STDOUT_FILENO);
+        // The report header names the algorithm of the golden file, whichever engine replays it.
+        if (ready) runScheduler(scheduler, names[a]);
+        if (ready) endPass();
+        restoreOutput(saved);
+
+        char *expected[GOLDEN_LINES], *produced[GOLDEN_LINES];
+        rewind(golden);
+        rewind(actual);
+        int expectedCount = readReportLines(golden, expected, GOLDEN_LINES);
+        int producedCount = readReportLines(actual, produced, GOLDEN_LINES);
+        fclose(golden);
+        fclose(actual);
+
+        // First line (in sorted order) that only one side has.
+        int e = 0, p = 0;
+        while (e < expectedCount && p < producedCount && strcmp(expected[e], produced[p]) == 0) e++, p++;
+        checked++;
+        if (expectedCount < 0 || producedCount < 0) {
+            failed++;
+            printf("%-28s %-10s DIFFERS, %s report has more than %d lines\n", entry->d_name, engine,
+                   expectedCount < 0 ? "golden" : "produced", GOLDEN_LINES);
+        } else if (e == expectedCount && p == producedCount) {
+            printf("%-28s %-10s ok\n", entry->d_name, engine);
+        } else {
+            failed++;
+            int missing = p == producedCount || (e < expectedCount && strcmp(expected[e], produced[p]) < 0);
+            printf("%-28s %-10s DIFFERS, %s: %s\n", entry->d_name, engine, missing ? "expected" : "unexpected",
+                   missing ? expected[e] : produced[p]);
+        }
+        for (int k = 0; k < expectedCount; k++) free(expected[k]);
+        for (int k = 0; k < producedCount; k++) free(produced[k]);
+    }
+    closedir(folder);
+    printf("%d of %d golden report(s) match.\n", checked - failed, checked);
+    fflush(stdout);
+    exit(0);
 }
 
-int timeToMinutes(char *time) {
-    int hour, minute;
-    sscanf(time, "%d:%d", &hour, &minute);
-    return hour * 60 + minute;
+// Resident set size of this process right now, in KB.
+long currentRssKb() {
+    long pages = 0, resident = 0;
+    FILE *file = fopen("/proc/self/statm", "r");
+    if (file == NULL) return 0;
+    if (fscanf(file, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(file);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
 }
 
-int durationToMinutes(float duration) {
-    return (int)(duration * 60); 
+// benchmarkRecords [count 1000000]
+// Memory and copy cost of <count> bookings held as full Booking structs and as the 32-byte
+// BookingRecords the site children send back: resident size, memcpy bandwidth, and packing time.
+#define RECORD_COPIES 5 // best of
+
+void benchmarkRecords(const char *args) {
+    long count = 1000000;
+    sscanf(args, " count %ld", &count);
+    if (count < 1 || count > 100000000) {
+        printf("Usage: benchmarkRecords [count 1000000]\n");
+        return;
+    }
+    size_t sizes[2] = {sizeof(Booking), sizeof(BookingRecord)};
+    const char *names[2] = {"Booking", "BookingRecord"};
+    double best[2];
+    long rss[2];
+
+    printf("\n*** Booking Records (%ld bookings) ***\n", count);
+    for (int k = 0; k < 2; k++) {
+        long before = currentRssKb();
+        char *source = malloc(count * sizes[k]), *target = malloc(count * sizes[k]);
+        if (source == NULL || target == NULL) {
+            printf("Cannot allocate %ld %ss.\n", count, names[k]);
+            free(source);
+            free(target);
+            return;
+        }
+        // Fill from the loaded bookings (or a blank one) so every page is resident.
+        for (long i = 0; i < count; i++) {
+            Booking b = totalBookings > 0 ? initialBookings[i % totalBookings] : (Booking){0};
+            b.passIndex = i % MAX_BOOKINGS;
+            if (k == 0) ((Booking *)source)[i] = b;
+            else ((BookingRecord *)source)[i] = packBooking(&b);
+        }
+        rss[k] = currentRssKb() - before;
+        best[k] = 1e30;
+        for (int r = 0; r < RECORD_COPIES; r++) {
+            double start = nowMs();
+            memcpy(target, source, count * sizes[k]);
+            double elapsed = nowMs() - start;
+            if (elapsed < best[k]) best[k] = elapsed;
+        }
+        free(source);
+        free(target);
+    }
+
+    Booking sample = totalBookings > 0 ? initialBookings[0] : (Booking){0};
+    volatile uint8_t sink = 0;
+    double start = nowMs();
+    for (long i = 0; i < count; i++) {
+        sample.passIndex = i % MAX_BOOKINGS;
+        sink ^= packBooking(&sample).status;
+    }
+    double packMs = nowMs() - start;
+
+    printf("%-14s %-10s %-12s %-12s %-10s\n", "Layout", "Bytes", "RSS MB", "Copy ms", "GB/s");
+    printf("============================================================\n");
+    for (int k = 0; k < 2; k++) {
+        printf("%-14s %-10zu %-12.1f %-12.2f %-10.2f\n", names[k], sizes[k], rss[k] / 1024.0, best[k],
+               count * sizes[k] / (best[k] / 1000) / 1e9);
+    }
+    printf("Packing: %.1f ns per booking. Records are %.1fx smaller and copy %.1fx faster.\n", packMs * 1e6 / count,
+           (double)sizes[0] / sizes[1], best[0] / best[1]);
 }
 
-int getResourceIndex(const char *resourceName) {
-    for (int i = 0; i < MAX_RESOURCES; i++) {
-        if (strcmp(resourceNames[i], resourceName) == 0) {
-            return i;
+// Copies one field of every record into a packed column of exportWidths[column] bytes per row.
+void gatherColumn(const BookingRecord *records, int rows, int column, unsigned char *out) {
+    for (int i = 0; i < rows; i++) {
+        const BookingRecord *r = &records[i];
+        switch (column) {
+            case 0: out[i] = r->member; break;
+            case 1: memcpy(out + 4 * (size_t)i, &r->day, 4); break;
+            case 2: memcpy(out + 2 * (size_t)i, &r->startMinute, 2); break;
+            case 3: memcpy(out + 2 * (size_t)i, &r->durationMinutes, 2); break;
+            case 4: out[i] = r->priority; break;
+            case 5: out[i] = r->resourceMask; break;
+            case 6: memcpy(out + 2 * (size_t)i, &r->slot, 2); break;
+            case 7: out[i] = r->status; break;
+            case 8: out[i] = r->reason; break;
+            default: out[i] = r->site; break;
         }
     }
-    return -1;
 }
 
-int contains(char essentials[MAX_RESOURCES][20], const char *item) {
-    for (int i = 0; i < MAX_RESOURCES; i++) {
-        if (strcmp(essentials[i], item) == 0) {
-            return i;
+// Writes the records of each algorithm (rows of them, in pass order) as a columnar file, one
+// fwrite per column. Returns NULL, or what went wrong.
+const char* writeExport(const char *path, const char *algorithms[], BookingRecord *records[], int algorithmCount, int rows) {
+    ExportHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, EXPORT_MAGIC, 8);
+    header.version = 1;
+    header.rows = rows;
+    header.algorithmCount = algorithmCount;
+    header.columnCount = EXPORT_COLUMNS;
+    uint64_t offset = (sizeof(header) + EXPORT_ALIGN - 1) / EXPORT_ALIGN * EXPORT_ALIGN;
+    size_t largest = 0;
+    for (int c = 0; c < EXPORT_COLUMNS; c++) {
+        snprintf(header.columns[c], sizeof(header.columns[c]), "%s", exportColumns[c]);
+        header.widths[c] = exportWidths[c];
+        if ((size_t)rows * exportWidths[c] > largest) largest = (size_t)rows * exportWidths[c];
+    }
+    for (int a = 0; a < algorithmCount; a++) {
+        snprintf(header.algorithms[a], sizeof(header.algorithms[a]), "%s", algorithms[a]);
+        for (int c = 0; c < EXPORT_COLUMNS; c++) {
+            header.offsets[a][c] = offset;
+            offset += ((uint64_t)rows * exportWidths[c] + EXPORT_ALIGN - 1) / EXPORT_ALIGN * EXPORT_ALIGN;
         }
     }
-    return -1;
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) return "Cannot create the export file";
+    unsigned char *column = calloc(largest + EXPORT_ALIGN, 1);
+    if (column == NULL) {
+        fclose(file);
+        return "Out of memory";
+    }
+    static const unsigned char padding[EXPORT_ALIGN];
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    size_t written = sizeof(header);
+    for (int a = 0; a < algorithmCount && ok; a++) {
+        for (int c = 0; c < EXPORT_COLUMNS && ok; c++) {
+            ok = fwrite(padding, 1, header.offsets[a][c] - written, file) == header.offsets[a][c] - written;
+            written = header.offsets[a][c];
+            gatherColumn(records[a], rows, c, column);
+            ok = ok && fwrite(column, exportWidths[c], rows, file) == (size_t)rows;
+            written += (size_t)rows * exportWidths[c];
+        }
+    }
+    free(column);
+    if (fclose(file) != 0) ok = 0;
+    return ok ? NULL : "Cannot write the export file";
 }
 
-void suggestAlternativeSlots(float durationHours, char *memberName, char *date, char *time) {
-    int durationMinutes = durationToMinutes(durationHours);
-    int originalStart = timeToMinutes(time);
-    int suggestions = 0;
+// exportSchedule -<file> [fcfs|prio|opti]: schedules the pending bookings with each algorithm
+// (all three by default) and writes the results with writeExport.
+void exportSchedule(const char *args) {
+    char path[64] = "", which[10] = "";
+    if (sscanf(args, " -%63s %9s", path, which) < 1) {
+        printf("Usage: exportSchedule -<file> [fcfs|prio|opti]\n");
+        return;
+    }
+    const char *names[3] = {"FCFS", "PRIORITY", "OPTIMIZED"};
+    const char *options[3] = {"fcfs", "prio", "opti"};
+    void (*schedulers[3])() = {processBookings_FCFS, processBookings_Priority, processBookings_Optimized};
+    const char *algorithms[3];
+    void (*chosen[3])();
+    int count = 0;
+    for (int a = 0; a < 3; a++) {
+        if (which[0] != 0 && strcmp(which, options[a]) != 0) continue;
+        algorithms[count] = names[a];
+        chosen[count++] = schedulers[a];
+    }
+    if (count == 0) {
+        printf("Usage: exportSchedule -<file> [fcfs|prio|opti]\n");
+        return;
+    }
+    if (!beginPass("")) return;
+
+    static BookingRecord records[3][MAX_PASS_BOOKINGS];
+    BookingRecord *columns[3];
+    float fragmentation[MAX_SITES];
+    double started = nowMs();
+    suggestionsEnabled = 0;
+    for (int a = 0; a < count; a++) {
+        memcpy(bookings, initialBookings, sizeof(bookings));
+        scheduleSites(chosen[a], fragmentation);
+        for (int i = 0; i < totalBookings; i++) records[a][bookings[i].passIndex] = packBooking(&bookings[i]);
+        columns[a] = records[a];
+    }
+    suggestionsEnabled = 1;
+    double scheduled = nowMs();
+    const char *error = writeExport(path, algorithms, columns, count, totalBookings);
+    if (error != NULL) printf("%s: %s\n", error, path);
+    else printf("Exported %d booking(s) x %d algorithm(s) to %s (scheduling %.3f ms, writing %.3f ms).\n",
+                totalBookings, count, path, scheduled - started, nowMs() - scheduled);
+    endPass();
+}
 
-    printf("Suggested alternative booking slots for %s on %s at %s:\n", memberName, date, time);
+// inspectExport -<file>: maps an export and summarises each algorithm from its columns, the way
+// analysis tooling would read it.
+void inspectExport(const char *path) {
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd == -1 || fstat(fd, &info) == -1 || (size_t)info.st_size < sizeof(ExportHeader)) {
+        printf("Cannot read export file: %s\n", path);
+        if (fd != -1) close(fd);
+        return;
+    }
+    const unsigned char *base = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        printf("Cannot map export file: %s\n", path);
+        return;
+    }
+    const ExportHeader *header = (const ExportHeader *)base;
+    int valid = memcmp(header->magic, EXPORT_MAGIC, 8) == 0 && header->version == 1 && header->columnCount == EXPORT_COLUMNS &&
+                header->algorithmCount >= 1 && header->algorithmCount <= 3;
+    // Every column must lie inside the file, aligned as writeExport lays it out, before it is
+    // read through a typed pointer.
+    for (uint32_t a = 0; valid && a < header->algorithmCount; a++) {
+        for (int c = 0; valid && c < EXPORT_COLUMNS; c++) {
+            uint64_t offset = header->offsets[a][c];
+            valid = header->widths[c] == exportWidths[c] && offset % EXPORT_ALIGN == 0 && offset >= sizeof(ExportHeader) &&
+                    offset <= (uint64_t)info.st_size && (uint64_t)header->rows * exportWidths[c] <= (uint64_t)info.st_size - offset;
+        }
+    }
+    if (!valid) {
+        printf("Not a schedule export: %s\n", path);
+        munmap((void *)base, info.st_size);
+        return;
+    }
 
-    // first suggest optimized successive slots
-    for (int i = 0; i < optimizedSlotCount && suggestions < 3; i++) {
-        OptimizedSlot *slot = &optimizedSlots[i];
-        if (strcmp(slot->date, date) == 0 && slot->durationMinutes >= durationMinutes) {
-            int startSlot = slot->startMinutes / 60;
-            int endSlot = (slot->startMinutes + durationMinutes) / 60 + ((slot->startMinutes + durationMinutes) % 60 > 0 ? 1 : 0);
-            int batteryIdx = getResourceIndex("battery");
-            if (slot->resourceCount[batteryIdx] >= 1) { 
-                printf(" -> Time slot: %02d:%02d (Optimized)\n", slot->startMinutes / 60, slot->startMinutes % 60);
-                suggestions++;
+    printf("%s: %u booking(s), %u algorithm(s), %ld bytes\n", path, header->rows, header->algorithmCount, (long)info.st_size);
+    printf("    %-10s %-9s %-9s %-10s %-14s\n", "Algorithm", "Accepted", "Rejected", "Bay-hours", "Busiest bay");
+    for (uint32_t a = 0; a < header->algorithmCount; a++) {
+        const uint8_t *status = base + header->offsets[a][7];
+        const uint16_t *duration = (const uint16_t *)(base + header->offsets[a][3]);
+        const int16_t *slot = (const int16_t *)(base + header->offsets[a][6]);
+        int accepted = 0, uses[MAX_BAYS] = {0}, busiest = 0;
+        float bayHours = 0;
+        for (uint32_t i = 0; i < header->rows; i++) {
+            accepted += status[i];
+            if (status[i] && slot[i] >= 0 && slot[i] < MAX_BAYS) {
+                bayHours += duration[i] / 60.0;
+                if (++uses[slot[i]] > uses[busiest]) busiest = slot[i];
             }
         }
+        char bay[24] = "-";
+        if (uses[busiest] > 0) snprintf(bay, sizeof(bay), "#%d (%d)", busiest, uses[busiest]);
+        printf("    %-10.15s %-9d %-9d %-10.1f %-14s\n", header->algorithms[a], accepted, header->rows - accepted, bayHours, bay);
     }
+    munmap((void *)base, info.st_size);
+}
 
-    // if suggestions < 3, suggest alternative time slots
-    if (suggestions < 3) {
-        for (int newStartMinutes = 0; newStartMinutes <= 1440 - durationMinutes && suggestions < 3; newStartMinutes += 60) {
-            int startSlot = newStartMinutes / 60;
-            int endSlot = (newStartMinutes + durationMinutes) / 60 + ((newStartMinutes + durationMinutes) % 60 > 0 ? 1 : 0);
-            int availableParking = 0;
-            for (int j = 0; j < PARKING_SLOTS; j++) {
-                int slotAvailable = 1;
-                for (int k = startSlot; k < endSlot; k++) {
-                    if (parkingAvailability[k][j] == 0) {
-                        slotAvailable = 0;
-                        break;
-                    }
-                }
-                if (slotAvailable) {
-                    availableParking = 1;
-                    break;
-                }
-            }
-            int batteryIdx = getResourceIndex("battery");
-            int resourcesAvailable = 1;
-            for (int slot = startSlot; slot < endSlot; slot++) {
-                if (resourceAvailability[slot][batteryIdx] < 1) {
-                    resourcesAvailable = 0;
-                    break;
-                }
-            }
-            if (availableParking && resourcesAvailable) {
-                int alreadySuggested = 0;
-                for (int j = 0; j < optimizedSlotCount; j++) {
-                    if (optimizedSlots[j].startMinutes == newStartMinutes && strcmp(optimizedSlots[j].date, date) == 0) {
-                        alreadySuggested = 1;
-                        break;
-                    }
-                }
-                if (!alreadySuggested) {
-                    printf(" -> Time slot: %02d:%02d\n", newStartMinutes / 60, newStartMinutes % 60);
-                    suggestions++;
-                }
-            }
+// benchmarkExport [count 1000000]
+// Time to write <count> scheduled bookings (the loaded ones repeated, or synthetic ones) as a
+// columnar export and as the fixed-width text of printBookings.
+void benchmarkExport(const char *args) {
+    long count = 1000000;
+    sscanf(args, " count %ld", &count);
+    if (count < 1 || count > 100000000) {
+        printf("Usage: benchmarkExport [count 1000000]\n");
+        return;
+    }
+    BookingRecord *records = malloc(count * sizeof(BookingRecord));
+    if (records == NULL) {
+        printf("Cannot allocate %ld records.\n", count);
+        return;
+    }
+    uint64_t state = 46;
+    for (long i = 0; i < count; i++) {
+        if (totalBookings > 0) {
+            Booking b = initialBookings[i % totalBookings];
+            b.passIndex = i % MAX_BOOKINGS;
+            b.accepted = i % 3 != 0;
+            b.parkingSlot = b.accepted ? i % PARKING_SLOTS : -1;
+            b.reason = b.accepted ? REASON_NONE : REASON_NO_BAY;
+            records[i] = packBooking(&b);
+        } else {
+            memset(&records[i], 0, sizeof(BookingRecord));
+            records[i].member = nextRandom(&state) % 5;
+            records[i].day = dateToDay("2025-05-12") + nextRandom(&state) % 30;
+            records[i].startMinute = nextRandom(&state) % 24 * 60;
+            records[i].durationMinutes = 60 * (1 + nextRandom(&state) % 4);
+            records[i].priority = 1 + nextRandom(&state) % 4;
+            records[i].status = nextRandom(&state) % 3 != 0;
+            records[i].slot = records[i].status ? (int16_t)(nextRandom(&state) % PARKING_SLOTS) : -1;
+            records[i].reason = records[i].status ? REASON_NONE : REASON_NO_BAY;
         }
     }
 
-    if (suggestions == 0) {
-        printf(" -> No suitable slots available.\n");
+    char columnar[64], text[64];
+    snprintf(columnar, sizeof(columnar), "/tmp/spms_export_%d.col", (int)getpid());
+    snprintf(text, sizeof(text), "/tmp/spms_export_%d.txt", (int)getpid());
+    const char *algorithms[1] = {"FCFS"};
+    double started = nowMs();
+    const char *error = writeExport(columnar, algorithms, &records, 1, count);
+    double columnarMs = nowMs() - started;
+
+    // The accepted/rejected rows of printBookings, with the same formatting work per row.
+    started = nowMs();
+    FILE *file = fopen(text, "w");
+    if (file == NULL) error = "Cannot create the text file";
+    for (long i = 0; i < count && file != NULL; i++) {
+        BookingRecord *r = &records[i];
+        char date[11], start[6], end[6];
+        dayToDate(r->day, date);
+        int endMinute = (r->startMinute + r->durationMinutes) % MINUTES_PER_DAY;
+        snprintf(start, sizeof(start), "%02d:%02d", r->startMinute / 60 % 24, r->startMinute % 60);
+        snprintf(end, sizeof(end), "%02d:%02d", endMinute / 60, endMinute % 60);
+        fprintf(file, "%-10s %-12s %-6s %-6s %-12s %-20s %-30s\n", members[r->member % 5], date, start, end,
+                getBookingType(r->priority), r->status ? "*" : "-", r->status ? "" : getReasonText(r->reason));
+    }
+    if (file != NULL) fclose(file);
+    double textMs = nowMs() - started;
+
+    struct stat columnarInfo = {0}, textInfo = {0};
+    stat(columnar, &columnarInfo);
+    stat(text, &textInfo);
+    remove(columnar);
+    remove(text);
+    free(records);
+    if (error != NULL) {
+        printf("%s\n", error);
+        return;
     }
-}
\ No newline at end of file
+    printf("\n*** Schedule Export (%ld bookings) ***\n", count);
+    printf("%-10s %-12s %-12s %-10s\n", "Format", "MB", "Write ms", "MB/s");
+    printf("============================================\n");
+    printf("%-10s %-12.1f %-12.1f %-10.0f\n", "columnar", columnarInfo.st_size / 1e6, columnarMs, columnarInfo.st_size / 1e3 / columnarMs);
+    printf("%-10s %-12.1f %-12.1f %-10.0f\n", "text", textInfo.st_size / 1e6, textMs, textInfo.st_size / 1e3 / textMs);
+    printf("Columnar export is %.1fx faster and %.1fx smaller.\n", textMs / columnarMs, (double)textInfo.st_size / columnarInfo.st_size);
+}